@@ -17,6 +17,8 @@ void cpu_instruction_callback(struct machine *machine,
 
 uint64_t cpu_cycles_run(struct machine *machine);
 
+bool cpu_idle(struct machine *machine);
+
 extern const struct device cpu_device;
 
 #endif /* ATARI_CPU_H */
@@ -9,6 +9,13 @@ struct cf2149_dac {
 	uint16_t lvl[32][32][32];
 };
 
-void cf2149_atari_st_dac(struct cf2149_dac *dac);
+/**
+ * cf2149_atari_st_dac - Atari ST YM2149 digital to analogue conversion table
+ *
+ * The table is generated at build time by lib/atari/dacgen.
+ *
+ * Return: shared conversion table, indexed by channels C, B and A
+ */
+const struct cf2149_dac *cf2149_atari_st_dac(void);
 
 #endif /* ATARI_DAC_H */
@@ -14,6 +14,21 @@ struct device_slice {
 	uint64_t s;
 };
 
+/* Devices are run in slot order, and events due together fire in slot order. */
+enum device_slot {
+	DEVICE_SLOT_ROM,
+	DEVICE_SLOT_GLUE,
+	DEVICE_SLOT_RAM,
+	DEVICE_SLOT_MFP,
+	DEVICE_SLOT_SHIFTER,
+	DEVICE_SLOT_PSG,
+	DEVICE_SLOT_SOUND,
+	DEVICE_SLOT_MIXER,
+	DEVICE_SLOT_FDC,
+	DEVICE_SLOT_CPU,
+	DEVICE_SLOT_COUNT
+};
+
 struct device_state {
 	void *internal;
 	size_t size;
@@ -21,6 +36,7 @@ struct device_state {
 
 struct device {
 	const char *name;
+	enum device_slot slot;
 
 	bool main_bus;
 	struct {
@@ -52,6 +68,10 @@ struct device {
 	void (*wr_u16)(struct machine *machine, const struct device *device,
 		uint32_t dev_address, uint16_t data);
 
+	/* Optional bulk write, for example to load programs into RAM. */
+	void (*wr)(struct machine *machine, const struct device *device,
+		uint32_t dev_address, const void *data, size_t size);
+
 	size_t (*id_u8)(struct machine *machine, const struct device *device,
 		uint32_t dev_address, char *buf, size_t size);
 	size_t (*id_u16)(struct machine *machine, const struct device *device,
@@ -66,7 +86,7 @@ const struct device *device_for_bus_address(struct machine *machine,
 struct device_cycle device_cycle(struct machine *machine,
 	const struct device *device);
 
-struct device_cycle device_from_machine_cycle(
+struct device_cycle device_from_machine_cycle(struct machine *machine,
 	const struct device *device, uint64_t machine_cycle);
 
 void request_device_event(struct machine *machine,
@@ -6,10 +6,18 @@
 #ifndef ATARI_M68K_H
 #define ATARI_M68K_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 struct m68k_module;
 
 int m68k_int_ack_callback(struct m68k_module *module, int level);
 
 void m68k_instruction_callback(struct m68k_module *module, int pc);
 
+bool m68k_instruction_cacheable(struct m68k_module *module, uint32_t pc);
+
+void m68k_instruction_cache_read(struct m68k_module *module,
+	uint32_t bus_address);
+
 #endif /* ATARI_M68K_H */
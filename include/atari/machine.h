@@ -21,11 +21,27 @@
 
 #define MACHINE_PROGRAM   0x40000	/* 256 KiB */
 #define MACHINE_RUN_SLICE   10000
+#define MACHINE_IDLE_SLICE 1000000
 
 struct device_cycle {
 	uint64_t c;
 };
 
+/**
+ * struct cycle_ratio - precomputed clock-domain conversion
+ * @to_frequency: reduced frequency to transform to
+ * @from_frequency: reduced frequency to transform from
+ * @reciprocal: %UINT64_MAX divided by @from_frequency
+ *
+ * The reciprocal replaces division by @from_frequency with a multiplication
+ * and at most one correction step, for exact results without division.
+ */
+struct cycle_ratio {
+	uint64_t to_frequency;
+	uint64_t from_frequency;
+	uint64_t reciprocal;
+};
+
 struct machine_registers {
 	uint32_t d[8];	/* Data registers */
 	uint32_t a[8];	/* Address registers */
@@ -36,12 +52,37 @@ struct machine_ports {
 	sound_sample_f sound_sample;
 	mixer_sample_f mixer_sample;
 	record_sample_f record_sample;
+	psg_register_f psg_register;
 	void *arg;
 };
 
 enum {
 	MACHINE_RAM_SIZE = 4 * 1024 * 1024,	/* 4 MiB of RAM */
+	MACHINE_RAM_PAGE_SHIFT = 12,		/* 4 KiB RAM pages */
+	MACHINE_RAM_PAGE_COUNT = MACHINE_RAM_SIZE >> MACHINE_RAM_PAGE_SHIFT,
 	DEVICE_LIST_MAX = 16,
+	BUS_PAGE_SHIFT = 16,			/* 64 KiB bus pages */
+	BUS_PAGE_COUNT = 1 << (24 - BUS_PAGE_SHIFT),	/* 24-bit bus */
+};
+
+/**
+ * struct machine_stats - machine statistics, counted with HAVE_STATS
+ * @instructions: number of instructions executed
+ * @cpu_cycles: number of CPU cycles executed
+ * @bus: number of processor bus accesses for each device slot
+ * @bus_error: number of processor bus accesses causing bus errors
+ * @event: number of device events fired for each device slot
+ * @interrupt: number of interrupt acknowledgements for each level
+ * @dma_sound_bytes: number of bytes fetched by DMA sound
+ */
+struct machine_stats {
+	uint64_t instructions;
+	uint64_t cpu_cycles;
+	uint64_t bus[DEVICE_LIST_MAX];
+	uint64_t bus_error;
+	uint64_t event[DEVICE_LIST_MAX];
+	uint64_t interrupt[8];
+	uint64_t dma_sound_bytes;
 };
 
 struct machine {
@@ -53,7 +94,14 @@ struct machine {
 
 	uint64_t cycle;
 
+	/*
+	 * Tracing is disabled unless @trace is set, with the device slots
+	 * to trace precomputed, by mmu_trace_mode().
+	 */
 	struct trace_mode *trace;
+	uint32_t trace_device;
+
+	struct machine_stats stats;
 
 	struct {
 		void (*cb)(uint32_t pc, void *arg);
@@ -65,9 +113,27 @@ struct machine {
 			struct machine_device {
 				uint64_t machine_cycle_event;
 				const struct device *device;
+				struct cycle_ratio from_machine;
+				struct cycle_ratio to_machine;
+				uint8_t event_position;
 			} d[DEVICE_LIST_MAX];
 		} list;
 
+		/*
+		 * Pending device events are kept in a binary min-heap of
+		 * device slots, ordered by machine cycle. Heap positions
+		 * start at 1, so that position 0 indicates no event.
+		 */
+		struct machine_device_event {
+			uint32_t due;
+			uint32_t count;
+			uint8_t heap[1 + DEVICE_LIST_MAX];
+		} event;
+
+		struct machine_bus_page {
+			const struct device *device[BUS_PAGE_COUNT];
+		} bus_page;
+
 		struct device_run_cycle {
 			uint64_t machine_slice_end;
 		} device_run_cycle;
@@ -123,16 +189,39 @@ struct machine {
 		struct {
 			psg_sample_f sample;
 			void *sample_arg;
+
+			psg_register_f capture;
+			void *capture_arg;
 		} output;
 	} psg;
 
 	struct {
+		/*
+		 * RAM is zero when the machine is allocated, for example
+		 * with calloc, and only pages written to are cleared by
+		 * reset. Untouched pages thereby remain demand-zero
+		 * memory that is never backed by the host.
+		 */
+		uint32_t dirty[MACHINE_RAM_PAGE_COUNT / 32];
+
+		/*
+		 * RAM pages with cached processor instructions, such that
+		 * RAM writes to other pages need not invalidate the cache.
+		 */
+		uint32_t code[MACHINE_RAM_PAGE_COUNT / 32];
+
 		uint8_t u8[MACHINE_RAM_SIZE];
 	} ram;
 
 	struct {
 		struct cf300588_sound_module cf300588;
 
+		/*
+		 * RAM pages that DMA sound may fetch from, such that RAM
+		 * writes to other pages need not be checked.
+		 */
+		uint32_t watch[MACHINE_RAM_PAGE_COUNT / 32];
+
 		struct {
 			sound_sample_f sample;
 			void *sample_arg;
@@ -147,6 +236,12 @@ uint64_t cycle_transform(uint64_t to_frequency, uint64_t from_frequency, uint64_
 
 uint64_t cycle_transform_align(uint64_t to_frequency, uint64_t from_frequency, uint64_t cycle);
 
+struct cycle_ratio cycle_ratio(uint64_t to_frequency, uint64_t from_frequency);
+
+uint64_t cycle_ratio_transform(const struct cycle_ratio *ratio, uint64_t cycle);
+
+uint64_t cycle_ratio_transform_align(const struct cycle_ratio *ratio, uint64_t cycle);
+
 uint64_t machine_cycle(struct machine *machine);
 
 void atari_st_init(struct machine *machine,
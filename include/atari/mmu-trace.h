@@ -9,14 +9,53 @@
 #include "internal/types.h"
 
 #include "atari/device.h"
+#include "atari/trace.h"
 
-void mmu_trace_rd_u8(struct machine *machine,
+/**
+ * mmu_trace_mode - set trace mode of machine
+ * @machine: machine to trace
+ * @trace: trace mode, or %NULL to disable tracing
+ *
+ * Device accesses cost a single test of the trace mode pointer when
+ * tracing is disabled, which it is if @trace is %NULL or has no devices.
+ */
+void mmu_trace_mode(struct machine *machine, struct trace_mode *trace);
+
+void mmu_trace_rd_u8__(struct machine *machine,
 	uint32_t dev_address, uint32_t value, const struct device *bd);
-void mmu_trace_rd_u16(struct machine *machine,
+void mmu_trace_rd_u16__(struct machine *machine,
 	uint32_t dev_address, uint32_t value, const struct device *bd);
-void mmu_trace_wr_u8(struct machine *machine,
+void mmu_trace_wr_u8__(struct machine *machine,
 	uint32_t dev_address, uint32_t value, const struct device *bd);
-void mmu_trace_wr_u16(struct machine *machine,
+void mmu_trace_wr_u16__(struct machine *machine,
 	uint32_t dev_address, uint32_t value, const struct device *bd);
 
+static inline void mmu_trace_rd_u8(struct machine *machine,
+	uint32_t dev_address, uint32_t value, const struct device *bd)
+{
+	if (machine->trace)
+		mmu_trace_rd_u8__(machine, dev_address, value, bd);
+}
+
+static inline void mmu_trace_rd_u16(struct machine *machine,
+	uint32_t dev_address, uint32_t value, const struct device *bd)
+{
+	if (machine->trace)
+		mmu_trace_rd_u16__(machine, dev_address, value, bd);
+}
+
+static inline void mmu_trace_wr_u8(struct machine *machine,
+	uint32_t dev_address, uint32_t value, const struct device *bd)
+{
+	if (machine->trace)
+		mmu_trace_wr_u8__(machine, dev_address, value, bd);
+}
+
+static inline void mmu_trace_wr_u16(struct machine *machine,
+	uint32_t dev_address, uint32_t value, const struct device *bd)
+{
+	if (machine->trace)
+		mmu_trace_wr_u16__(machine, dev_address, value, bd);
+}
+
 #endif /* ATARI_MMU_TRACE_H */
@@ -18,4 +18,7 @@ extern const struct device psg_device;
 void psg_sample(struct machine *machine,
 	psg_sample_f sample, void *sample_arg);
 
+void psg_capture(struct machine *machine,
+	psg_register_f capture, void *capture_arg);
+
 #endif /* ATARI_PSG_H */
@@ -7,6 +7,9 @@
 #define ATARI_RAM_H
 
 #include "atari/bus.h"
+#include "atari/sound.h"
+
+#include "m68k/m68k.h"
 
 struct ram_map_ro {
 	size_t size;
@@ -19,4 +22,66 @@ struct ram_map_ro ram_map_ro(struct machine *machine,
 
 extern const struct device ram_device;
 
+static inline uint8_t ram_read_u8(struct machine *machine,
+	uint32_t dev_address)
+{
+	return machine->ram.u8[dev_address];
+}
+
+static inline uint16_t ram_read_u16(struct machine *machine,
+	uint32_t dev_address)
+{
+	return (machine->ram.u8[dev_address] << 8) |
+		machine->ram.u8[dev_address + 1];
+}
+
+static inline void ram_dirty(struct machine *machine, uint32_t dev_address)
+{
+	const uint32_t page = dev_address >> MACHINE_RAM_PAGE_SHIFT;
+
+	machine->ram.dirty[page / 32] |= 1u << (page % 32);
+}
+
+static inline void ram_cache_code(struct machine *machine, uint32_t dev_address)
+{
+	const uint32_t page = dev_address >> MACHINE_RAM_PAGE_SHIFT;
+
+	machine->ram.code[page / 32] |= 1u << (page % 32);
+}
+
+static inline bool ram_code_cached(struct machine *machine, uint32_t dev_address)
+{
+	const uint32_t page = dev_address >> MACHINE_RAM_PAGE_SHIFT;
+
+	return (machine->ram.code[page / 32] & (1u << (page % 32))) != 0;
+}
+
+static inline void ram_write_u8(struct machine *machine,
+	uint32_t dev_address, uint8_t data)
+{
+	if (sound_watched(machine, dev_address))
+		sound_check(machine, dev_address);
+	if (ram_code_cached(machine, dev_address))
+		m68k_instruction_cache_invalidate(&machine->cpu.m68k,
+			dev_address);
+	ram_dirty(machine, dev_address);
+
+	machine->ram.u8[dev_address] = data;
+}
+
+static inline void ram_write_u16(struct machine *machine,
+	uint32_t dev_address, uint16_t data)
+{
+	if (sound_watched(machine, dev_address))
+		sound_check(machine, dev_address);
+	if (ram_code_cached(machine, dev_address))
+		m68k_instruction_cache_invalidate(&machine->cpu.m68k,
+			dev_address);
+	ram_dirty(machine, dev_address);
+	ram_dirty(machine, dev_address + 1);
+
+	machine->ram.u8[dev_address] = data >> 8;
+	machine->ram.u8[dev_address + 1] = data & 0xff;
+}
+
 #endif /* ATARI_RAM_H */
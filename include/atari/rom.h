@@ -10,4 +10,8 @@
 
 extern const struct device rom_device;
 
+uint8_t rom_read_u8(uint32_t dev_address);
+
+uint16_t rom_read_u16(uint32_t dev_address);
+
 #endif /* ATARI_ROM_H */
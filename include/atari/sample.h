@@ -39,4 +39,7 @@ typedef void (*mixer_sample_f)(
 
 typedef void (*record_sample_f)(uint64_t cycle, void *arg);
 
+typedef void (*psg_register_f)(uint64_t cycle,
+	uint8_t reg, uint8_t value, void *arg);
+
 #endif /* ATARI_SAMPLE_H */
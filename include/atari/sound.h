@@ -7,6 +7,7 @@
 #define ATARI_SOUND_H
 
 #include "atari/bus.h"
+#include "atari/machine.h"
 #include "atari/sample.h"
 
 extern const struct device sound_device;
@@ -19,4 +20,11 @@ void record_sample(struct machine *machine,
 
 void sound_check(struct machine *machine, uint32_t bus_address);
 
+static inline bool sound_watched(struct machine *machine, uint32_t bus_address)
+{
+	const uint32_t page = bus_address >> MACHINE_RAM_PAGE_SHIFT;
+
+	return machine->sound.watch[page / 32] & (1u << (page % 32));
+}
+
 #endif /* ATARI_SOUND_H */
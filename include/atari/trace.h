@@ -32,8 +32,42 @@ TRACE_DEVICE(TRACE_DEVICE_ENUM)
 #define TRACE_ENABLE(trace_mode_, label_)				\
 	((trace_mode_)->m & TRACE_DEVICE_ ## label_)
 
+/* Traces made by the CPU rather than by devices, only available as text. */
+#define TRACE_DEVICE_TEXT (TRACE_DEVICE_WCH | TRACE_DEVICE_CPU | TRACE_DEVICE_REG)
+
+enum trace_format {
+	TRACE_FORMAT_TEXT,
+	TRACE_FORMAT_BINARY,
+};
+
+#define TRACE_BINARY_MAGIC "PSGT"
+
+/**
+ * struct trace_record - binary trace record of a device access
+ * @cycle: machine cycle of access
+ * @address: bus address
+ * @value: value read or written
+ * @op: %TRACE_OP_WR for writes, and %TRACE_OP_U16 for 16-bit accesses
+ * @slot: device slot, as given by &enum device_slot
+ *
+ * A binary trace begins with the four octets %TRACE_BINARY_MAGIC and the
+ * 32-bit record size, followed by the records. All integers are in host
+ * byte order.
+ */
+struct trace_record {
+	uint64_t cycle;
+	uint32_t address;
+	uint16_t value;
+	uint8_t op;
+	uint8_t slot;
+};
+
+#define TRACE_OP_WR  0x1
+#define TRACE_OP_U16 0x2
+
 struct trace_mode {
 	uint32_t m;
+	enum trace_format format;
 	FILE *file;
 	const char *output;
 };
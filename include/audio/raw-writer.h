@@ -0,0 +1,17 @@
+// SPDX-License-Identifier: GPL-2.0
+
+#ifndef PSGPLAY_RAW_WRITER_H
+#define PSGPLAY_RAW_WRITER_H
+
+#include "audio/writer.h"
+
+/*
+ * Raw output is headerless 16-bit little-endian interleaved stereo, as in
+ * the data chunk of the WAVE format.
+ */
+extern const struct audio_writer raw_writer;
+
+/* The nonfatal raw writer reports errors and fails, as the WAVE writer. */
+extern const struct audio_writer raw_writer_nonfatal;
+
+#endif /* PSGPLAY_RAW_WRITER_H */
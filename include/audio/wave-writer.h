@@ -7,4 +7,10 @@
 
 extern const struct audio_writer wave_writer;
 
+/*
+ * The nonfatal WAVE writer reports errors and fails, rather than exiting:
+ * open gives %NULL, write gives zero and close gives %false.
+ */
+extern const struct audio_writer wave_writer_nonfatal;
+
 #endif /* PSGPLAY_WAVE_WRITER_H */
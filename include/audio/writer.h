@@ -8,15 +8,19 @@
 
 #include "internal/types.h"
 
+#include "psgplay/stereo.h"
+
 struct audio_writer {
 	void *(*open)(const char *output, int frequency,
 		bool nonblocking, size_t sample_length);
 	bool (*sample)(int16_t left, int16_t right, void *arg);
+	size_t (*write)(const struct psgplay_stereo *buffer, size_t count,
+		void *arg);
 	bool (*pause)(void *arg);
 	bool (*resume)(void *arg);
 	void (*flush)(void *arg);
 	void (*drop)(void *arg);
-	void (*close)(void *arg);
+	bool (*close)(void *arg);
 };
 
 #endif /* PSGPLAY_WRITER_H */
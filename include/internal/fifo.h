@@ -60,6 +60,10 @@ size_t fifo_peek(struct fifo *f, const void **buf);
 
 size_t fifo_skip(struct fifo *f, size_t size);
 
+size_t fifo_reserve(struct fifo *f, void **buf);
+
+size_t fifo_commit(struct fifo *f, size_t size);
+
 static inline void fifo_clear(struct fifo *f)
 {
 	f->size = f->index = 0;
@@ -0,0 +1,26 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (C) 2026 Fredrik Noring
+ */
+
+#ifndef INTERNAL_POLYPHASE_H
+#define INTERNAL_POLYPHASE_H
+
+#include <stdint.h>
+
+#define POLYPHASE_TAPS		128	/* Filter length in input samples */
+#define POLYPHASE_PHASES	256	/* Fractional input sample positions */
+#define POLYPHASE_SHIFT		14	/* Fixed-point coefficient fraction bits */
+
+/**
+ * struct polyphase_table - polyphase windowed-sinc filter coefficients
+ * @frequency: output sample frequency, in Hz
+ * @coefficient: fixed-point coefficients for each phase, where each phase
+ * 	sums to 1 and the first coefficient applies to the most recent sample
+ */
+struct polyphase_table {
+	int frequency;
+	int16_t coefficient[POLYPHASE_PHASES][POLYPHASE_TAPS];
+};
+
+#endif /* INTERNAL_POLYPHASE_H */
@@ -12,7 +12,9 @@
 #include "atari/dac.h"
 #include "atari/machine.h"
 
+#include "psgplay/digital.h"
 #include "psgplay/stereo.h"
+#include "psgplay/ym.h"
 
 struct fir8 {
 	int16_t xn[8];
@@ -24,6 +26,7 @@ struct stereo_buffer {
 	size_t count;
 	size_t capacity;
 	size_t total;
+	uint64_t reallocations;
 	struct psgplay_stereo *sample;
 };
 
@@ -37,12 +40,31 @@ struct digital_buffer {
 	size_t capacity;
 	size_t total;
 	size_t stop;
+	uint64_t reallocations;
 	struct psgplay_digital *sample;
 };
 
+/**
+ * struct psgplay_silence - silence detection
+ * @threshold: number of digital samples of silence to stop after, or zero
+ * 	to never stop at silence
+ * @start: digital sample index where the latest silence began
+ * @write: digital sample index of the latest PSG register change
+ * @psg: PSG registers, shadowed by register writes
+ * @sample: latest digital sample
+ */
+struct psgplay_silence {
+	size_t threshold;
+	size_t start;
+	size_t write;
+	uint8_t psg[16];
+	struct psgplay_digital sample;
+};
+
 struct psgplay {
 	struct stereo_buffer stereo_buffer;
 	struct digital_buffer digital_buffer;
+	struct psgplay_silence silence;
 
 	struct {
 		uint64_t psg;
@@ -62,7 +84,7 @@ struct psgplay {
 		} lowpass;
 	} downsample;
 
-	struct cf2149_dac dac;
+	const struct cf2149_dac *dac;
 
 	struct {
 		psgplay_digital_to_stereo_cb cb;
@@ -81,6 +103,11 @@ struct psgplay {
 		void *arg;
 	} instruction_callback;
 
+	struct {
+		psgplay_psg_register_cb cb;
+		void *arg;
+	} psg_register_callback;
+
 	int errno_;
 };
 
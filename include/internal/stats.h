@@ -0,0 +1,21 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (C) 2026 Fredrik Noring
+ */
+
+#ifndef INTERNAL_STATS_H
+#define INTERNAL_STATS_H
+
+/*
+ * Statistics counters are compiled in with HAVE_STATS, for example with
+ * make STATS=1, and otherwise compile to nothing.
+ */
+#ifdef HAVE_STATS
+#define stats_add(counter, n) ((counter) += (n))
+#else
+#define stats_add(counter, n) ((void)0)
+#endif
+
+#define stats_inc(counter) stats_add(counter, 1)
+
+#endif /* INTERNAL_STATS_H */
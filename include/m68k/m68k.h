@@ -306,6 +306,19 @@ void m68k_pulse_reset(struct m68k_module *module);
 /* execute num_cycles worth of instructions.  returns number of cycles used */
 int m68k_execute(struct m68k_module *module, int num_cycles);
 
+/* Invalidate cached instructions that include the given address, which
+ * must be called for every write to an address for which
+ * M68K_INSTRUCTION_CACHEABLE() was true.
+ * You must enable M68K_INSTRUCTION_CACHE in m68kconf.h.
+ */
+void m68k_instruction_cache_invalidate(struct m68k_module *module, unsigned int address);
+
+/* Invalidate all cached instructions, for example when memory was changed
+ * by other means than processor writes.
+ * You must enable M68K_INSTRUCTION_CACHE in m68kconf.h.
+ */
+void m68k_instruction_cache_flush(struct m68k_module *module);
+
 /* These functions let you read/write/modify the number of cycles left to run
  * while m68k_execute() is running.
  * These are useful if the 68k accesses a memory-mapped port on another device
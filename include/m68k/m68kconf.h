@@ -144,6 +144,21 @@
 #define M68K_INSTRUCTION_CALLBACK(module, pc) m68k_instruction_callback(module, pc)
 
 
+/* If ON, the CPU will cache predecoded instructions, with their opcode,
+ * first extension word and handler, such that unmodified instructions are
+ * not read from memory and decoded again. Instructions are cached only at
+ * addresses for which M68K_INSTRUCTION_CACHEABLE() is true, and
+ * M68K_INSTRUCTION_CACHE_READ() is called in place of every 16-bit read
+ * the cache makes unnecessary. All writes to such addresses must be given
+ * to m68k_instruction_cache_invalidate().
+ * NOTE: This is only implemented for OPT_SPECIFY_HANDLER.
+ */
+#define M68K_INSTRUCTION_CACHE      OPT_SPECIFY_HANDLER
+#define M68K_INSTRUCTION_CACHE_SIZE 2048 /* Entries, a power of two */
+#define M68K_INSTRUCTION_CACHEABLE(module, A) m68k_instruction_cacheable(module, A)
+#define M68K_INSTRUCTION_CACHE_READ(module, A) m68k_instruction_cache_read(module, A)
+
+
 /* If ON, the CPU will emulate the 4-byte prefetch queue of a real 68000 */
 #define M68K_EMULATE_PREFETCH       OPT_ON
 
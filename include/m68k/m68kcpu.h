@@ -342,6 +342,23 @@ typedef uint32 uint64;
 #define CPU_INSTR_MODE   module->m68ki_cpu.instr_mode
 #define CPU_RUN_MODE     module->m68ki_cpu.run_mode
 
+/* With only the 68000 emulated, its cycles are constants in the handlers */
+#define M68K_EMULATE_000_ONLY (!M68K_EMULATE_010 && !M68K_EMULATE_EC020 && \
+	!M68K_EMULATE_020 && !M68K_EMULATE_030 && !M68K_EMULATE_040)
+
+#if M68K_EMULATE_000_ONLY
+#define CYC_INSTRUCTION  m68ki_cycles[0]
+#define CYC_EXCEPTION    m68ki_exception_cycle_table[0]
+#define CYC_BCC_NOTAKE_B (-2)
+#define CYC_BCC_NOTAKE_W 2
+#define CYC_DBCC_F_NOEXP (-2)
+#define CYC_DBCC_F_EXP   2
+#define CYC_SCC_R_TRUE   2
+#define CYC_MOVEM_W      2
+#define CYC_MOVEM_L      3
+#define CYC_SHIFT        1
+#define CYC_RESET        132
+#else
 #define CYC_INSTRUCTION  module->m68ki_cpu.cyc_instruction
 #define CYC_EXCEPTION    module->m68ki_cpu.cyc_exception
 #define CYC_BCC_NOTAKE_B module->m68ki_cpu.cyc_bcc_notake_b
@@ -353,6 +370,7 @@ typedef uint32 uint64;
 #define CYC_MOVEM_L      module->m68ki_cpu.cyc_movem_l
 #define CYC_SHIFT        module->m68ki_cpu.cyc_shift
 #define CYC_RESET        module->m68ki_cpu.cyc_reset
+#endif /* M68K_EMULATE_000_ONLY */
 #define HAS_PMMU	 module->m68ki_cpu.has_pmmu
 #define PMMU_ENABLED	 module->m68ki_cpu.pmmu_enabled
 #define RESET_CYCLES	 module->m68ki_cpu.reset_cycles
@@ -990,10 +1008,6 @@ struct m68k_module {
 	unsigned int default_pc_changed_callback_data;
 	unsigned int default_set_fc_callback_data;
 
-	unsigned char m68ki_cycles[NUM_CPU_TYPES][0x10000]; /* Cycles used by CPU type */
-
-	void (*m68ki_instruction_jump_table[0x10000])(struct m68k_module *module); /* opcode handler jump table */
-
 #if !defined(__m68k__)
 	jmp_buf m68ki_bus_error_jmp_buf;
 #endif
@@ -1005,6 +1019,21 @@ struct m68k_module {
 #endif
 #endif /* M68K_EMULATE_ADDRESS_ERROR */
 
+#if M68K_INSTRUCTION_CACHE
+	/* Direct-mapped cache of predecoded instructions, indexed by PC */
+	struct m68ki_instruction_cache {
+		struct m68ki_instruction {
+			void (*handler)(struct m68k_module *module);
+			uint tag;	/* PC + 1, or 0 if invalid */
+			uint16 ir;	/* Opcode */
+			uint16 ext;	/* First extension word, for the prefetch */
+		} entry[M68K_INSTRUCTION_CACHE_SIZE];
+
+		/* Set if the prefetched word was written after it was read */
+		int prefetch_modified;
+	} m68ki_instruction_cache;
+#endif /* M68K_INSTRUCTION_CACHE */
+
 	struct {
 		void *arg;
 	} callback;
@@ -1014,6 +1043,7 @@ extern const uint8    m68ki_shift_8_table[];
 extern const uint16   m68ki_shift_16_table[];
 extern const uint     m68ki_shift_32_table[];
 extern const uint8    m68ki_exception_cycle_table[][256];
+extern const unsigned char m68ki_cycles[][0x10000];
 extern const uint8    m68ki_ea_idx_cycle_table[];
 
 /* Forward declarations to keep some of the macros happy */
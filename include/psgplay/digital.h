@@ -121,6 +121,29 @@ struct psgplay_digital {
 ssize_t psgplay_read_digital(struct psgplay *pp,
 	struct psgplay_digital *buffer, size_t count);
 
+/**
+ * psgplay_peek_digital - peek at PSG play digital samples without copying
+ * @pp: PSG play object
+ * @buffer: pointer to internal buffer of digital samples, can be %NULL
+ *
+ * The internal buffer remains valid until any other PSG play function
+ * than psgplay_consume_digital() is called. Samples are removed from the
+ * buffer with psgplay_consume_digital().
+ *
+ * Return: number of available samples, zero for end of samples indicating
+ * PSG play has been stopped, or negative on failure
+ */
+ssize_t psgplay_peek_digital(struct psgplay *pp,
+	const struct psgplay_digital **buffer);
+
+/**
+ * psgplay_consume_digital - consume peeked PSG play digital samples
+ * @pp: PSG play object
+ * @count: number of digital samples to consume, at most as many as
+ * 	returned by psgplay_peek_digital()
+ */
+void psgplay_consume_digital(struct psgplay *pp, size_t count);
+
 /**
  * psgplay_stop_digital_at_sample - stop PSG play after a given sample index
  * @pp: PSG play object to stop
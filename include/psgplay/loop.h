@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (C) 2026 Fredrik Noring
+ */
+
+#ifndef PSGPLAY_LOOP_H
+#define PSGPLAY_LOOP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * struct psgplay_loop - loop of an SNDH tune
+ * @start: time in seconds, from the start of the SNDH tune, of the loop
+ * @length: length in seconds of the loop
+ * @end: %true if the loop is a single replay tick, which means the tune
+ * 	has ended at @start, for example by having fallen silent
+ */
+struct psgplay_loop {
+	float start;
+	float length;
+	bool end;
+};
+
+/**
+ * psgplay_loop - detect when an SNDH tune loops or ends
+ * @loop: loop result, if detected
+ * @data: SNDH data, must not be in compressed form
+ * @size: SNDH size in octets
+ * @track: subtune to analyse
+ * @limit: maximum time in seconds to analyse
+ *
+ * The tune is emulated without sound, and the machine state is
+ * fingerprinted each time the SNDH play subroutine is called. The
+ * fingerprint covers the YM2149 PSG registers, the DMA sound registers,
+ * and RAM, where only pages written since the previous call are hashed
+ * again. A repeated fingerprint is taken to be a loop.
+ *
+ * This is a heuristic. The fingerprint omits the CPU registers, the MFP
+ * timer state and the internal PSG tone, noise and envelope counters, so
+ * a tune that depends on these may be reported to loop early. The RAM is
+ * also summarised by a 64-bit hash, so a collision is possible, although
+ * unlikely.
+ *
+ * Return: 1 if a loop was detected, 0 if none was detected within @limit,
+ * 	or -1 with errno set on failure
+ */
+int psgplay_loop(struct psgplay_loop *loop,
+	const void *data, size_t size, int track, float limit);
+
+#endif /* PSGPLAY_LOOP_H */
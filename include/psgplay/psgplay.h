@@ -89,4 +89,85 @@ void psgplay_unstop(struct psgplay *pp);
  */
 void psgplay_stop_at_time(struct psgplay *pp, float time);
 
+/**
+ * psgplay_stop_at_silence - stop PSG play after a given time of silence
+ * @pp: PSG play object to stop
+ * @time: time in seconds of continuous silence to stop after, or zero to
+ * 	never stop at silence
+ *
+ * Silence is when the PSG channel levels and the DMA sound levels are
+ * constant, and no PSG register is changed. PSG play is stopped at the end
+ * of the given time of silence, and fades out as with psgplay_stop(). This
+ * saves emulating tracks that end in silence, or whose durations are
+ * overestimated.
+ *
+ * See also psgplay_stop_at_time() and psgplay_unstop().
+ */
+void psgplay_stop_at_silence(struct psgplay *pp, float time);
+
+/**
+ * psgplay_skip - skip PSG play samples
+ * @pp: PSG play object
+ * @count: number of stereo sample pairs to skip, or digital samples if
+ * 	PSG play was initialised without a stereo frequency
+ *
+ * Skipping is much faster than reading samples into a %NULL buffer, since
+ * stereo samples are neither mixed nor faded, except for the last few. The
+ * machine is emulated exactly, and the downsampler keeps its phase, but
+ * the stereo samples that follow are only approximately those that reading
+ * would give. The downsampler history is filled with silence rather than
+ * with the skipped samples, the blocks that digital samples are mixed in
+ * are shifted, which changes when the mixer volume is enabled for a block,
+ * and fades within the skipped samples are not applied.
+ *
+ * Return: number of skipped samples, less than @count only if PSG play
+ * has been stopped, or negative on failure
+ */
+ssize_t psgplay_skip(struct psgplay *pp, size_t count);
+
+struct psgplay_snapshot;	/* PSG play snapshot object */
+
+/**
+ * psgplay_snapshot - take a snapshot of PSG play
+ * @pp: PSG play object to take a snapshot of
+ *
+ * The snapshot holds the complete emulator state, including pending digital
+ * and stereo samples as well as the default downsampler, such that reading
+ * can be resumed from this point with psgplay_restore(), for example to seek
+ * quickly without emulating from the start of the SNDH tune.
+ *
+ * Note: State kept behind callback arguments is not included. The polyphase
+ * resampler has its own psgplay_stereo_polyphase_snapshot() for this.
+ *
+ * RAM is stored by written pages only, which is typically a few hundred
+ * KiB or less.
+ *
+ * Return: PSG play snapshot object, which must be freed with
+ * 	psgplay_snapshot_free(), or %NULL on failure
+ */
+struct psgplay_snapshot *psgplay_snapshot(const struct psgplay *pp);
+
+/**
+ * psgplay_restore - restore PSG play to a snapshot
+ * @pp: PSG play object to restore
+ * @snapshot: snapshot previously taken of @pp with psgplay_snapshot()
+ *
+ * Callbacks, such as the ones set by psgplay_digital_to_stereo_callback()
+ * and psgplay_stereo_downsample_callback(), are retained. A snapshot can
+ * be restored any number of times.
+ *
+ * Return: zero on success, or -1 with errno set to %EINVAL if @snapshot
+ * 	was not taken of @pp
+ */
+int psgplay_restore(struct psgplay *pp,
+	const struct psgplay_snapshot *snapshot);
+
+/**
+ * psgplay_snapshot_free - free a PSG play snapshot object
+ * @snapshot: PSG play snapshot object to free
+ *
+ * Note: If @snapshot is %NULL, no operation is performed.
+ */
+void psgplay_snapshot_free(struct psgplay_snapshot *snapshot);
+
 #endif /* PSGPLAY_H */
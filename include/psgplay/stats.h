@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (C) 2026 Fredrik Noring
+ */
+
+#ifndef PSGPLAY_STATS_H
+#define PSGPLAY_STATS_H
+
+#include <stdint.h>
+
+#include "psgplay/psgplay.h"
+
+/**
+ * struct psgplay_stats_device - counters for each Atari ST device
+ * @rom: ROM
+ * @glue: GLUE, with HBL and VBL interrupts
+ * @ram: RAM
+ * @mfp: MC68901 multi-function peripheral
+ * @shifter: video shifter
+ * @psg: YM2149 programmable sound generator
+ * @sound: DMA sound
+ * @mixer: LMC1992 mixer with microwire interface
+ * @fdc: floppy disk controller
+ * @bus_error: bus error, for unmapped addresses
+ */
+struct psgplay_stats_device {
+	uint64_t rom;
+	uint64_t glue;
+	uint64_t ram;
+	uint64_t mfp;
+	uint64_t shifter;
+	uint64_t psg;
+	uint64_t sound;
+	uint64_t mixer;
+	uint64_t fdc;
+	uint64_t bus_error;
+};
+
+/**
+ * struct psgplay_stats - emulator statistics
+ * @instructions: number of 68000 instructions executed
+ * @cpu_cycles: number of 68000 cycles executed, including bus wait states
+ * @bus: number of 68000 bus accesses for each device, where 32-bit
+ * 	accesses count as two 16-bit accesses
+ * @event: number of device events fired for each device
+ * @interrupt: number of interrupt acknowledgements for each level 0 to 7
+ * @dma_sound_bytes: number of bytes fetched by DMA sound
+ * @reallocation: number of buffer reallocations
+ * @reallocation.stereo: stereo sample buffer reallocations
+ * @reallocation.digital: digital sample buffer reallocations
+ */
+struct psgplay_stats {
+	uint64_t instructions;
+	uint64_t cpu_cycles;
+
+	struct psgplay_stats_device bus;
+	struct psgplay_stats_device event;
+
+	uint64_t interrupt[8];
+
+	uint64_t dma_sound_bytes;
+
+	struct {
+		uint64_t stereo;
+		uint64_t digital;
+	} reallocation;
+};
+
+/**
+ * psgplay_stats - emulator statistics for a PSG play object
+ * @pp: PSG play object
+ * @stats: statistics counted since psgplay_init(), including counts made
+ * 	before restoring a snapshot
+ *
+ * Statistics are counted only if PSG play was compiled with them, for
+ * example with make STATS=1, since counting has a small cost on the most
+ * frequently used paths of the emulator.
+ *
+ * Return: 0 on success, or -1 with errno set to %ENOSYS if statistics were
+ * 	compiled out, in which case @stats is zero
+ */
+int psgplay_stats(const struct psgplay *pp, struct psgplay_stats *stats);
+
+#endif /* PSGPLAY_STATS_H */
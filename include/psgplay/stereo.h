@@ -12,6 +12,7 @@
 
 struct psgplay;		/* PSG play object */
 struct psgplay_digital;	/* PSG play digital sample */
+struct psgplay_stereo_polyphase;	/* PSG play polyphase resampler */
 
 /**
  * struct psgplay_stereo - PSG play stereo sample
@@ -35,6 +36,29 @@ struct psgplay_stereo {
 ssize_t psgplay_read_stereo(struct psgplay *pp,
 	struct psgplay_stereo *buffer, size_t count);
 
+/**
+ * psgplay_peek_stereo - peek at PSG play stereo samples without copying
+ * @pp: PSG play object
+ * @buffer: pointer to internal buffer of stereo samples, can be %NULL
+ *
+ * The internal buffer remains valid until any other PSG play function
+ * than psgplay_consume_stereo() is called. Samples are removed from the
+ * buffer with psgplay_consume_stereo().
+ *
+ * Return: number of available stereo sample pairs, zero for end of samples
+ * indicating PSG play has been stopped, or negative on failure
+ */
+ssize_t psgplay_peek_stereo(struct psgplay *pp,
+	const struct psgplay_stereo **buffer);
+
+/**
+ * psgplay_consume_stereo - consume peeked PSG play stereo samples
+ * @pp: PSG play object
+ * @count: number of stereo sample pairs to consume, at most as many as
+ * 	returned by psgplay_peek_stereo()
+ */
+void psgplay_consume_stereo(struct psgplay *pp, size_t count);
+
 /**
  * psgplay_digital_to_stereo_cb - callback type to transform digital samples
  * 	into stereo samples
@@ -155,4 +179,68 @@ typedef size_t (*psgplay_stereo_downsample_cb)(
 void psgplay_stereo_downsample_callback(struct psgplay *pp,
 	const psgplay_stereo_downsample_cb cb, void *arg);
 
+/**
+ * psgplay_stereo_polyphase_init - initialise polyphase stereo resampler
+ * @frequency: output sample frequency, in Hz, being 44100, 48000 or 96000
+ *
+ * The polyphase resampler is a windowed-sinc lowpass filter with much
+ * better rejection of aliasing than the default downsampler. Its filter
+ * coefficients are precomputed for the supported sample frequencies.
+ *
+ * Return: polyphase resampler, or %NULL on failure, with errno set to
+ * 	%EINVAL for an unsupported sample frequency
+ */
+struct psgplay_stereo_polyphase *psgplay_stereo_polyphase_init(
+	int frequency);
+
+/**
+ * psgplay_stereo_downsample_polyphase - polyphase downsample of stereo samples
+ * @resample: downsampled stereo samples
+ * @stereo: 250.332 kHz stereo samples
+ * @count: number of stereo samples to downsample
+ * @arg: pointer to struct psgplay_stereo_polyphase
+ *
+ * The resampler frequency must be the same as the stereo frequency given
+ * to psgplay_init().
+ *
+ * Return: number of resamples, equal or less than @count
+ */
+size_t psgplay_stereo_downsample_polyphase(struct psgplay_stereo *resample,
+	const struct psgplay_stereo *stereo, size_t count, void *arg);
+
+/**
+ * psgplay_stereo_polyphase_snapshot - take a snapshot of a polyphase resampler
+ * @polyphase: polyphase resampler to take a snapshot of
+ *
+ * The sample history and phase of the resampler are kept behind the
+ * callback argument, and are therefore not included in psgplay_snapshot().
+ * Take and restore snapshots of both to resume reading exactly.
+ *
+ * Return: polyphase resampler snapshot, which must be freed with
+ * 	psgplay_stereo_polyphase_free(), or %NULL on failure
+ */
+struct psgplay_stereo_polyphase *psgplay_stereo_polyphase_snapshot(
+	const struct psgplay_stereo_polyphase *polyphase);
+
+/**
+ * psgplay_stereo_polyphase_restore - restore polyphase resampler to a snapshot
+ * @polyphase: polyphase resampler to restore
+ * @snapshot: snapshot previously taken with
+ * 	psgplay_stereo_polyphase_snapshot()
+ *
+ * Return: zero on success, or -1 with errno set to %EINVAL if @snapshot
+ * 	is for another output sample frequency
+ */
+int psgplay_stereo_polyphase_restore(
+	struct psgplay_stereo_polyphase *polyphase,
+	const struct psgplay_stereo_polyphase *snapshot);
+
+/**
+ * psgplay_stereo_polyphase_free - free polyphase stereo resampler
+ * @polyphase: polyphase resampler to free
+ *
+ * Note: If @polyphase is %NULL, no operation is performed.
+ */
+void psgplay_stereo_polyphase_free(struct psgplay_stereo_polyphase *polyphase);
+
 #endif /* PSGPLAY_STEREO_H */
@@ -0,0 +1,130 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (C) 2026 Fredrik Noring
+ */
+
+#ifndef PSGPLAY_YM_H
+#define PSGPLAY_YM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "psgplay/psgplay.h"
+
+#define PSGPLAY_PSG_FREQUENCY 2002653	/* YM2149 PSG clock in Hz */
+
+/**
+ * struct psgplay_psg_register - YM2149 PSG register write
+ * @cycle: PSG cycle of write, with %PSGPLAY_PSG_FREQUENCY cycles per second
+ * @reg: register 0 to 15
+ * @value: value written to register
+ */
+struct psgplay_psg_register {
+	uint64_t cycle;
+	uint8_t reg;
+	uint8_t value;
+};
+
+/**
+ * typedef psgplay_psg_register_cb - callback for YM2149 PSG register writes
+ * @pp: PSG play object
+ * @reg: register write
+ * @arg: argument supplied to psgplay_psg_register_callback()
+ */
+typedef void (*psgplay_psg_register_cb)(struct psgplay *pp,
+	const struct psgplay_psg_register *reg, void *arg);
+
+/**
+ * psgplay_psg_register_callback - invoke callback for every PSG register write
+ * @pp: PSG play object
+ * @cb: callback, or %NULL to disable
+ * @arg: optional argument supplied to @cb, can be %NULL
+ *
+ * Writes are captured in the order made by the emulated 68000, with
+ * nondecreasing cycles. Writes made by the SNDH init subroutine precede
+ * psgplay_psg_play_cycle().
+ */
+void psgplay_psg_register_callback(struct psgplay *pp,
+	psgplay_psg_register_cb cb, void *arg);
+
+/**
+ * psgplay_psg_play_cycle - PSG cycle of the first digital sample
+ * @pp: PSG play object
+ *
+ * The SNDH tune begins to play with its first play subroutine call, which
+ * is also the first digital and stereo sample. The cycle is determined by
+ * the time the first sample is read.
+ *
+ * Return: PSG cycle at which the SNDH tune begins to play
+ */
+uint64_t psgplay_psg_play_cycle(const struct psgplay *pp);
+
+/**
+ * psgplay_psg_register_log - encode PSG register writes into a compact log
+ * @buf: buffer to encode into, can be %NULL if @size is zero
+ * @size: size in bytes of buffer
+ * @start: PSG cycle of the start of the log, typically given by
+ * 	psgplay_psg_play_cycle()
+ * @reg: register writes in order
+ * @count: number of register writes
+ *
+ * The log begins with the four octets "PSGR" followed by the PSG clock
+ * frequency in Hz as a 32-bit big-endian integer. Each write is then
+ * encoded as the number of PSG cycles since the previous write, or since
+ * @start for the first one, in unsigned LEB128 form, followed by one octet
+ * for the register and one octet for the value. Writes preceding @start
+ * are given as being made at @start, to form the initial state.
+ *
+ * Return: size in bytes of the complete log, which is greater than @size
+ * 	if the log was truncated
+ */
+size_t psgplay_psg_register_log(void *buf, size_t size, uint64_t start,
+	const struct psgplay_psg_register *reg, size_t count);
+
+/**
+ * struct psgplay_ym - YM file properties
+ * @version: YM file version, 5 or 6
+ * @frame_rate: frames per second, typically 50 for the SNDH VBL timer
+ * @frame_count: number of frames, or zero to end with the last write
+ * @loop_frame: frame to restart at when the end has been reached
+ * @start: PSG cycle of the first frame, typically given by
+ * 	psgplay_psg_play_cycle()
+ * @title: song name, or %NULL
+ * @author: author name, or %NULL
+ * @comment: comment, or %NULL
+ */
+struct psgplay_ym {
+	int version;
+	int frame_rate;
+	size_t frame_count;
+	size_t loop_frame;
+	uint64_t start;
+	const char *title;
+	const char *author;
+	const char *comment;
+};
+
+/**
+ * psgplay_ym - encode PSG register writes into a YM5 or YM6 file
+ * @buf: buffer to encode into, can be %NULL if @size is zero
+ * @size: size in bytes of buffer
+ * @ym: YM file properties
+ * @reg: register writes in order
+ * @count: number of register writes
+ *
+ * Each frame has the registers as they are at the end of the frame, in
+ * interleaved order. Register 13 is 0xff for frames in which the envelope
+ * shape was not written, such that the envelope is not restarted. Writes
+ * faster than the frame rate, for example sampled sound made with timer
+ * interrupts, are thereby lost, in which case psgplay_psg_register_log()
+ * is a lossless alternative.
+ *
+ * Return: size in bytes of the complete YM file, which is greater than
+ * 	@size if the file was truncated, or -1 with errno set to %EINVAL
+ * 	for invalid properties
+ */
+ssize_t psgplay_ym(void *buf, size_t size, const struct psgplay_ym *ym,
+	const struct psgplay_psg_register *reg, size_t count);
+
+#endif /* PSGPLAY_YM_H */
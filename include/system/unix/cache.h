@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (C) 2026 Fredrik Noring
+ */
+
+#ifndef PSGPLAY_SYSTEM_UNIX_CACHE_H
+#define PSGPLAY_SYSTEM_UNIX_CACHE_H
+
+#include "internal/types.h"
+
+#define CACHE_SIZE_DEFAULT (1024 * 1024 * 1024)	/* 1 GiB */
+
+/**
+ * struct cache - on-disk cache of rendered sample streams
+ * @dir: directory of cache entries
+ * @size_limit: maximum total size in bytes of all entries, after which
+ * 	the least recently used entries are removed
+ *
+ * Entries are files named by a hash of their key. They are written to
+ * temporary files while rendering, and renamed into place once complete,
+ * such that concurrent readers only ever see complete entries. The
+ * modification time of an entry is updated when it is read, which
+ * orders entries for least recently used removal.
+ *
+ * Samples are stored run-length encoded, as consecutive identical samples
+ * are common in both the digital and the stereo streams.
+ */
+struct cache {
+	const char *dir;
+	uint64_t size_limit;
+};
+
+/**
+ * cache_size_option - parse a cache size option
+ * @s: size in MiB, as a nonnegative decimal number
+ *
+ * Exits with an error message if @s is not a valid size.
+ *
+ * Return: size in bytes
+ */
+uint64_t cache_size_option(const char *s);
+
+/**
+ * cache_key - make a cache key for SNDH data and render settings
+ * @data: SNDH data
+ * @size: size in bytes of SNDH data
+ * @track: track to render
+ * @frequency: stereo sample frequency in Hz, or zero for digital samples
+ * @mix: digital to stereo transform with its parameters, or %NULL
+ * @stop: stop time in seconds
+ * @silence: time in seconds of silence to stop after, or zero
+ *
+ * The key includes the PSG play version, such that entries rendered by
+ * other versions are not used.
+ *
+ * Return: key that must be freed
+ */
+char *cache_key(const void *data, size_t size, int track, int frequency,
+	const char *mix, float stop, float silence);
+
+struct cache_reader;	/* Memory-mapped cache entry */
+
+/**
+ * cache_reader_open - open a cache entry for reading
+ * @cache: cache
+ * @key: key of entry
+ * @record_size: size in bytes of each sample
+ *
+ * Return: cache reader, which must be closed with cache_reader_close(),
+ * 	or %NULL if there is no complete entry for @key
+ */
+struct cache_reader *cache_reader_open(const struct cache *cache,
+	const char *key, size_t record_size);
+
+/**
+ * cache_read - read samples from a cache entry
+ * @reader: cache reader
+ * @buffer: buffer to read into, can be %NULL to skip samples
+ * @count: number of samples to read
+ *
+ * Return: number of samples read, which is less than @count only at the
+ * 	end of the entry
+ */
+size_t cache_read(struct cache_reader *reader, void *buffer, size_t count);
+
+void cache_reader_close(struct cache_reader *reader);
+
+struct cache_writer;	/* Cache entry being written */
+
+/**
+ * cache_writer_open - open a cache entry for writing
+ * @cache: cache
+ * @key: key of entry
+ * @record_size: size in bytes of each sample
+ *
+ * Return: cache writer, which must be closed with cache_writer_close(),
+ * 	or %NULL on failure
+ */
+struct cache_writer *cache_writer_open(const struct cache *cache,
+	const char *key, size_t record_size);
+
+/**
+ * cache_write - write samples to a cache entry
+ * @writer: cache writer
+ * @buffer: samples to write
+ * @count: number of samples to write
+ */
+void cache_write(struct cache_writer *writer,
+	const void *buffer, size_t count);
+
+/**
+ * cache_writer_close - close a cache entry written to
+ * @writer: cache writer, can be %NULL
+ * @commit: %true if all samples have been written, in which case the entry
+ * 	replaces any previous one for the same key, otherwise it is discarded
+ *
+ * The least recently used entries are removed if the cache has become too
+ * large.
+ */
+void cache_writer_close(struct cache_writer *writer, bool commit);
+
+#endif /* PSGPLAY_SYSTEM_UNIX_CACHE_H */
@@ -16,4 +16,6 @@
 void command_replay(const struct options *options, struct file file,
 	const struct audio_writer *output);
 
+void command_export(const struct options *options, struct file file);
+
 #endif /* PSGPLAY_SYSTEM_UNIX_COMMAND_MODE_H */
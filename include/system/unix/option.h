@@ -31,6 +31,7 @@ struct options {
 	const char *start;
 	const char *stop;
 	const char *length;
+	const char *silence;
 
 	const char *mode;
 
@@ -41,6 +42,12 @@ struct options {
 	struct psgplay_psg_stereo_balance psg_balance;
 	struct psgplay_psg_stereo_volume psg_volume;
 
+	const char *cache;
+	uint64_t cache_size;
+
+	const char *export_ym;
+	const char *export_format;
+
 	const char *input;
 
 	struct trace_mode trace;
@@ -57,6 +64,7 @@ bool text_mode_option(void);
 
 psgplay_digital_to_stereo_cb psg_mix_option(void);
 void *psg_mix_arg(void);
+char *psg_mix_key(void);
 
 struct options *parse_options(int argc, char **argv);
 
@@ -0,0 +1,19 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (C) 2026 Fredrik Noring
+ */
+
+#ifndef PSGPLAY_TEST_SNDHLOOP_H
+#define PSGPLAY_TEST_SNDHLOOP_H
+
+#include "internal/macro.h"
+
+#define SNDH_LOOP_FREQUENCY 200
+#define SNDH_LOOP_START 100
+#define SNDH_LOOP_END 300
+
+/* The tune has no time, which is instead given by loop detection. */
+#define tune_value_time_names(t)					\
+	t(SNDH_LOOP_END, 0, "SNDH loop at tick " XSTR(SNDH_LOOP_END))
+
+#endif /* PSGPLAY_TEST_SNDHLOOP_H */
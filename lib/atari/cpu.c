@@ -5,6 +5,8 @@
  * FIXME: Supervisor address access
  */
 
+#include "internal/stats.h"
+
 #include "atari/cpu.h"
 #include "atari/device.h"
 #include "atari/machine.h"
@@ -16,6 +18,8 @@ void m68k_instruction_callback(struct m68k_module *module, int pc)
 {
 	struct machine *machine = machine_from_m68k_module(module);
 
+	stats_inc(machine->stats.instructions);
+
 #if 0	/* FIXME */
 	printf("%08x: %04x %s\n", pc, REG_IR,
 		m68ki_disassemble_quick(pc, M68K_CPU_TYPE_68000));
@@ -46,6 +50,19 @@ uint64_t cpu_cycles_run(struct machine *machine)
 	return cycles_run;
 }
 
+bool cpu_idle(struct machine *machine)
+{
+	const struct m68k_module *module = &machine->cpu.m68k;
+
+	if (CPU_STOPPED & STOP_LEVEL_HALT)
+		return true;
+
+	/* A stopped CPU remains so until an interrupt above its mask. */
+	return (CPU_STOPPED & STOP_LEVEL_STOP) &&
+		!module->m68ki_cpu.nmi_pending &&
+		CPU_INT_LEVEL <= FLAG_INT_MASK;
+}
+
 static struct device_slice cpu_run(struct machine *machine,
 	const struct device *device, struct device_cycle device_cycle,
 	struct device_slice device_slice)
@@ -58,6 +75,8 @@ static struct device_slice cpu_run(struct machine *machine,
 	BUG_ON(s < 0);
 #endif
 
+	stats_add(machine->stats.cpu_cycles, s);
+
 	return (struct device_slice) { .s = s };
 }
 
@@ -74,6 +93,7 @@ static void cpu_reset(struct machine *machine, const struct device *device)
 
 const struct device cpu_device = {
 	.name = "cpu",
+	.slot = DEVICE_SLOT_CPU,
 	.clk = {
 		.frequency = CPU_FREQUENCY,
 		.divisor = 1
@@ -4,6 +4,7 @@
  */
 
 #include "internal/compare.h"
+#include "internal/stats.h"
 #include "internal/struct.h"
 #include "internal/types.h"
 
@@ -33,20 +34,15 @@
 	     (machine_device_) - &(list)->d[0] < ARRAY_SIZE((list)->d);	\
 	     (machine_device_)++)
 
-#define for_each_device_event(list, machine_device_)			\
-	for_each_device_state((list), machine_device_)			\
-		if (!(machine_device_)->machine_cycle_event) continue; else
-
 bool valid_device_bus_address(uint32_t bus_address, const struct device *dev)
 {
 	return dev->bus.address <= bus_address &&
 		bus_address < dev->bus.address + dev->bus.size;
 }
 
-const struct device *device_for_bus_address(struct machine *machine,
-	uint32_t bus_address)
+static const struct device *device_scan_bus_address(
+	struct machine_device_list *list, uint32_t bus_address)
 {
-	struct machine_device_list *list = &machine->device.list;
 	const struct device *device;
 
 	for_each_device (list, device)
@@ -56,92 +52,268 @@ const struct device *device_for_bus_address(struct machine *machine,
 	return &bus_device_error;
 }
 
-struct device_cycle device_cycle(struct machine *machine,
-	const struct device *device)
+const struct device *device_for_bus_address(struct machine *machine,
+	uint32_t bus_address)
+{
+	struct machine_bus_page *bus_page = &machine->device.bus_page;
+	const uint32_t page = bus_address >> BUS_PAGE_SHIFT;
+
+	if (page >= ARRAY_SIZE(bus_page->device))
+		return &bus_device_error;
+
+	const struct device *device = bus_page->device[page];
+
+	/* Pages shared by several devices, such as I/O, are scanned. */
+	return device ? device :
+		device_scan_bus_address(&machine->device.list, bus_address);
+}
+
+static const struct device *bus_page_device(
+	struct machine_device_list *list, uint32_t page)
+{
+	const uint32_t page_address = page << BUS_PAGE_SHIFT;
+	const uint32_t page_end = page_address + (1 << BUS_PAGE_SHIFT);
+	const struct device *page_device = &bus_device_error;
+	const struct device *device;
+
+	for_each_device (list, device) {
+		const uint32_t device_end = device->bus.address + device->bus.size;
+
+		if (!device->bus.size ||
+		    device_end <= page_address ||
+		    page_end <= device->bus.address)
+			continue;
+
+		if (page_device != &bus_device_error ||
+		    page_address < device->bus.address ||
+		    device_end < page_end)
+			return NULL;	/* Shared or partially mapped page */
+
+		page_device = device;
+	}
+
+	return page_device;
+}
+
+static void bus_page_reset(struct machine *machine)
+{
+	struct machine_bus_page *bus_page = &machine->device.bus_page;
+
+	for (uint32_t page = 0; page < ARRAY_SIZE(bus_page->device); page++)
+		bus_page->device[page] =
+			bus_page_device(&machine->device.list, page);
+}
+
+static struct machine_device *machine_device_for_device(
+	struct machine_device_list *list, const struct device *device)
+{
+	return &list->d[device->slot];
+}
+
+static uint64_t device_frequency(const struct device *device)
+{
+	return device->clk.frequency / device->clk.divisor;
+}
+
+static struct device_cycle machine_device_cycle(
+	const struct machine_device *machine_device, uint64_t machine_cycle)
 {
 	return (struct device_cycle) {
-		.c = cycle_transform(device->clk.frequency / device->clk.divisor,
-			CPU_FREQUENCY, machine_cycle(machine))
+		.c = cycle_ratio_transform(&machine_device->from_machine,
+			machine_cycle)
 	};
 }
 
-struct device_cycle device_from_machine_cycle(
+struct device_cycle device_from_machine_cycle(struct machine *machine,
 	const struct device *device, uint64_t machine_cycle)
 {
-	return (struct device_cycle) {
-		.c = cycle_transform(device->clk.frequency / device->clk.divisor,
-			CPU_FREQUENCY, machine_cycle)
-	};
+	return machine_device_cycle(
+		machine_device_for_device(&machine->device.list, device),
+		machine_cycle);
+}
+
+struct device_cycle device_cycle(struct machine *machine,
+	const struct device *device)
+{
+	return device_from_machine_cycle(machine, device,
+		machine_cycle(machine));
 }
 
 static struct device_slice device_from_machine_slice(
-	const struct device *device, uint64_t machine_slice)
+	const struct machine_device *machine_device, uint64_t machine_slice)
 {
 	return (struct device_slice) {
-		.s = cycle_transform(device->clk.frequency / device->clk.divisor,
-			CPU_FREQUENCY, machine_slice)
+		.s = cycle_ratio_transform(&machine_device->from_machine,
+			machine_slice)
 	};
 }
 
-static uint64_t machine_from_device_cycle_align(const struct device *device,
+static uint64_t machine_from_device_cycle_align(
+	const struct machine_device *machine_device,
 	const struct device_cycle device_cycle)
 {
-	return cycle_transform_align(CPU_FREQUENCY,
-			device->clk.frequency / device->clk.divisor, device_cycle.c);
+	return cycle_ratio_transform_align(&machine_device->to_machine,
+		device_cycle.c);
 }
 
-static uint64_t machine_from_device_slice(const struct device *device,
+static uint64_t machine_from_device_slice(
+	const struct machine_device *machine_device,
 	const struct device_slice device_slice)
 {
-	return cycle_transform(CPU_FREQUENCY,
-			device->clk.frequency / device->clk.divisor, device_slice.s);
+	return cycle_ratio_transform(&machine_device->to_machine,
+		device_slice.s);
+}
+
+static uint64_t event_cycle(struct machine *machine, uint8_t slot)
+{
+	return machine->device.list.d[slot].machine_cycle_event;
+}
+
+static bool event_before(struct machine *machine, uint8_t a, uint8_t b)
+{
+	const uint64_t a_cycle = event_cycle(machine, a);
+	const uint64_t b_cycle = event_cycle(machine, b);
+
+	return a_cycle < b_cycle || (a_cycle == b_cycle && a < b);
+}
+
+static void event_place(struct machine *machine, uint32_t position, uint8_t slot)
+{
+	machine->device.event.heap[position] = slot;
+	machine->device.list.d[slot].event_position = position;
+}
+
+static void event_sift_up(struct machine *machine, uint32_t position)
+{
+	struct machine_device_event *event = &machine->device.event;
+	const uint8_t slot = event->heap[position];
+
+	for (; position > 1 &&
+	       event_before(machine, slot, event->heap[position / 2]);
+	     position /= 2)
+		event_place(machine, position, event->heap[position / 2]);
+
+	event_place(machine, position, slot);
+}
+
+static void event_sift_down(struct machine *machine, uint32_t position)
+{
+	struct machine_device_event *event = &machine->device.event;
+	const uint8_t slot = event->heap[position];
+
+	for (uint32_t child; (child = 2 * position) <= event->count;
+	     position = child) {
+		if (child < event->count &&
+		    event_before(machine, event->heap[child + 1],
+				event->heap[child]))
+			child++;
+
+		if (!event_before(machine, event->heap[child], slot))
+			break;
+
+		event_place(machine, position, event->heap[child]);
+	}
+
+	event_place(machine, position, slot);
+}
+
+static void event_insert(struct machine *machine, uint8_t slot)
+{
+	struct machine_device_event *event = &machine->device.event;
+
+	event_place(machine, ++event->count, slot);
+	event_sift_up(machine, event->count);
+}
+
+static void event_remove(struct machine *machine, uint8_t slot)
+{
+	struct machine_device_event *event = &machine->device.event;
+	const uint32_t position = machine->device.list.d[slot].event_position;
+	const uint8_t last = event->heap[event->count--];
+
+	machine->device.list.d[slot].event_position = 0;
+
+	if (last == slot)
+		return;
+
+	event_place(machine, position, last);
+	event_sift_up(machine, position);
+	event_sift_down(machine,
+		machine->device.list.d[last].event_position);
+}
+
+static uint8_t event_first(struct machine *machine)
+{
+	return machine->device.event.heap[1];
 }
 
 void request_device_event(struct machine *machine,
 	const struct device *device, struct device_cycle device_cycle)
 {
-	struct machine_device_list *list = &machine->device.list;
+	struct machine_device *machine_device =
+		machine_device_for_device(&machine->device.list, device);
 	const uint64_t machine_cycle =
-		machine_from_device_cycle_align(device, device_cycle);
-	struct machine_device *machine_device = NULL;
+		machine_from_device_cycle_align(machine_device, device_cycle);
+	const uint32_t due = 1u << device->slot;
 
 	if (machine->device.device_run_cycle.machine_slice_end &&
 	    machine->device.device_run_cycle.machine_slice_end > machine_cycle)
 		m68k_end_timeslice(&machine->cpu.m68k);
 
-	for (size_t i = 0; i < ARRAY_SIZE(list->d); i++)
-		if (list->d[i].device == device) {
-			machine_device = &list->d[i];
-			break;
-		}
-#if 0  /* FIXME: Dependency on pr_bug */
-	BUG_ON(!machine_device);
-#endif
+	if (machine_device->machine_cycle_event &&
+	    machine_cycle >= machine_device->machine_cycle_event)
+		return;
 
-	if (!machine_device->machine_cycle_event ||
-	    machine_cycle < machine_device->machine_cycle_event)
-		machine_device->machine_cycle_event = machine_cycle;
+	machine_device->machine_cycle_event = machine_cycle;
+
+	/* An event at machine cycle 0 is indistinguishable from no event. */
+	if (machine->device.event.due & due) {
+		if (!machine_cycle)
+			machine->device.event.due &= ~due;
+	} else if (machine_device->event_position) {
+		if (machine_cycle)
+			event_sift_up(machine, machine_device->event_position);
+		else
+			event_remove(machine, device->slot);
+	} else if (machine_cycle)
+		event_insert(machine, device->slot);
 }
 
 void device_reset(struct machine *machine)
 {
 	struct machine_device_list *list = &machine->device.list;
+	struct machine_device *machine_device;
 	const struct device *device;
 
 	*list = (struct machine_device_list) {
 		{
-			{ .device = &rom_device     },
-			{ .device = &glue_device    },
-			{ .device = &ram_device     },
-			{ .device = &mfp_device     },
-			{ .device = &shifter_device },
-			{ .device = &psg_device     },
-			{ .device = &sound_device   },
-			{ .device = &mixer_device   },
-			{ .device = &fdc_device     },
-			{ .device = &cpu_device     },
+			[DEVICE_SLOT_ROM]     = { .device = &rom_device     },
+			[DEVICE_SLOT_GLUE]    = { .device = &glue_device    },
+			[DEVICE_SLOT_RAM]     = { .device = &ram_device     },
+			[DEVICE_SLOT_MFP]     = { .device = &mfp_device     },
+			[DEVICE_SLOT_SHIFTER] = { .device = &shifter_device },
+			[DEVICE_SLOT_PSG]     = { .device = &psg_device     },
+			[DEVICE_SLOT_SOUND]   = { .device = &sound_device   },
+			[DEVICE_SLOT_MIXER]   = { .device = &mixer_device   },
+			[DEVICE_SLOT_FDC]     = { .device = &fdc_device     },
+			[DEVICE_SLOT_CPU]     = { .device = &cpu_device     },
 		}
 	};
+	machine->device.event = (struct machine_device_event) { };
+
+	/* Clock-domain conversions are precomputed to avoid division. */
+	for_each_device_state (list, machine_device)
+		if (machine_device->device) {
+			const uint64_t frequency =
+				device_frequency(machine_device->device);
+
+			machine_device->from_machine =
+				cycle_ratio(frequency, CPU_FREQUENCY);
+			machine_device->to_machine =
+				cycle_ratio(CPU_FREQUENCY, frequency);
+		}
+
+	bus_page_reset(machine);
 
 	for_each_device (list, device)
 		if (device->reset)
@@ -149,8 +321,11 @@ void device_reset(struct machine *machine)
 }
 
 static struct device_slice run(struct machine *machine,
-	const struct device *device, uint64_t machine_cycle, uint64_t machine_slice)
+	const struct machine_device *machine_device,
+	uint64_t machine_cycle, uint64_t machine_slice)
 {
+	const struct device *device = machine_device->device;
+
 	if (!device->run)
 		return (struct device_slice) { };
 
@@ -160,47 +335,97 @@ static struct device_slice run(struct machine *machine,
 
 	const struct device_slice slice =
 		device->run(machine, device,
-			device_from_machine_cycle(device, machine_cycle),
-			device_from_machine_slice(device, machine_slice));
+			machine_device_cycle(machine_device, machine_cycle),
+			device_from_machine_slice(machine_device, machine_slice));
 
 	machine->device.device_run_cycle = (struct device_run_cycle) { };
 
 	return slice;
 }
 
+/*
+ * Due events fire in slot order. Events that become due for a later slot
+ * while firing also fire, whereas those for an earlier slot are retained
+ * for the next run.
+ */
+static void device_event(struct machine *machine, uint64_t machine_cycle)
+{
+	struct machine_device_event *event = &machine->device.event;
+	uint32_t slot = 0;
+
+	for (;;) {
+		while (event->count &&
+		       event_cycle(machine, event_first(machine)) <= machine_cycle) {
+			const uint8_t first = event_first(machine);
+
+			event_remove(machine, first);
+			event->due |= 1u << first;
+		}
+
+		const uint32_t due = event->due & ~((1u << slot) - 1);
+
+		if (!due)
+			break;
+
+		struct machine_device *machine_device =
+			&machine->device.list.d[__builtin_ctz(due)];
+
+		slot = machine_device->device->slot;
+		event->due &= ~(1u << slot);
+		machine_device->machine_cycle_event = 0;
+
+		stats_inc(machine->stats.event[slot]);
+
+		machine_device->device->event(machine, machine_device->device,
+			machine_device_cycle(machine_device, machine_cycle));
+
+		slot++;
+	}
+
+	while (event->due) {
+		const uint8_t first = __builtin_ctz(event->due);
+
+		event->due &= ~(1u << first);
+		event_insert(machine, first);
+	}
+}
+
 uint64_t device_run(struct machine *machine, uint64_t machine_cycle, uint64_t machine_slice)
 {
 	struct machine_device_list *list = &machine->device.list;
 	struct machine_device *machine_device;
 
-	for_each_device_event (list, machine_device)
-		if (machine_device->machine_cycle_event <= machine_cycle) {
-			machine_device->machine_cycle_event = 0;
+	device_event(machine, machine_cycle);
 
-			machine_device->device->event(machine,
-				machine_device->device,
-				device_from_machine_cycle(
-					machine_device->device, machine_cycle));
-		}
+	if (machine->device.event.count) {
+		const uint64_t event_machine_cycle =
+			event_cycle(machine, event_first(machine));
 
-	for_each_device_event (list, machine_device)
-		if (machine_device->machine_cycle_event <= machine_cycle)
-			machine_slice = 0;
-		else
-			machine_slice = min(machine_slice,
-				machine_device->machine_cycle_event - machine_cycle);
+		if (event_machine_cycle <= machine_cycle)
+			return 0;
+
+		/*
+		 * An idle CPU cannot change anything until the next event,
+		 * which may interrupt it, so the machine skips ahead to it.
+		 */
+		machine_slice = min(cpu_idle(machine) ?
+				MACHINE_IDLE_SLICE : machine_slice,
+			event_machine_cycle - machine_cycle);
+	}
 
 	if (!machine_slice)
 		return 0;
 
-	const struct device *device;
+	for_each_device_state (list, machine_device) {
+		if (!machine_device->device)
+			break;
 
-	for_each_device (list, device) {
 		struct device_slice device_slice =
-			run(machine, device, machine_cycle, machine_slice);
+			run(machine, machine_device, machine_cycle, machine_slice);
 
 		if (device_slice.s)
-			return machine_from_device_slice(device, device_slice);
+			return machine_from_device_slice(machine_device,
+				device_slice);
 	}
 
 	return machine_slice;
@@ -61,6 +61,7 @@ static void fdc_reset(struct machine *machine, const struct device *device)
 
 const struct device fdc_device = {
 	.name = "fdc",
+	.slot = DEVICE_SLOT_FDC,
 	.clk = {
 		.frequency = CPU_FREQUENCY,
 		.divisor = 1
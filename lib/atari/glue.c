@@ -7,6 +7,8 @@
 
 #include "toslibc/asm/machine.h"
 
+#include "internal/stats.h"
+
 #include "atari/bus.h"
 #include "atari/glue.h"
 #include "atari/irq.h"
@@ -100,6 +102,8 @@ int m68k_int_ack_callback(struct m68k_module *module, int level)
 {
 	struct machine *machine = machine_from_m68k_module(module);
 
+	stats_inc(machine->stats.interrupt[level & 7]);
+
 	switch(level)
 	{
 	case IRQ_HBL: return glue_hbl(machine);
@@ -111,6 +115,7 @@ int m68k_int_ack_callback(struct m68k_module *module, int level)
 
 const struct device glue_device = {
 	.name = "glue",
+	.slot = DEVICE_SLOT_GLUE,
 	.clk = {
 		.frequency = CPU_FREQUENCY,
 		.divisor = 1
@@ -57,6 +57,85 @@ uint64_t cycle_transform_align(uint64_t to_frequency, uint64_t from_frequency, u
 		(r * to_frequency + from_frequency - 1) / from_frequency;
 }
 
+static uint64_t gcd(uint64_t a, uint64_t b)
+{
+	while (b) {
+		const uint64_t r = a % b;
+
+		a = b;
+		b = r;
+	}
+
+	return a;
+}
+
+struct cycle_ratio cycle_ratio(uint64_t to_frequency, uint64_t from_frequency)
+{
+	const uint64_t d = gcd(to_frequency, from_frequency);
+
+	return (struct cycle_ratio) {
+		.to_frequency = to_frequency / d,
+		.from_frequency = from_frequency / d,
+		.reciprocal = UINT64_MAX / (from_frequency / d),
+	};
+}
+
+static uint64_t mul_hi_u64(uint64_t a, uint64_t b)
+{
+	const uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+	const uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+	const uint64_t lo_lo = a_lo * b_lo;
+	const uint64_t hi_lo = a_hi * b_lo;
+	const uint64_t lo_hi = a_lo * b_hi;
+	const uint64_t cross = (lo_lo >> 32) + (uint32_t)hi_lo + lo_hi;
+
+	return a_hi * b_hi + (hi_lo >> 32) + (cross >> 32);
+}
+
+/*
+ * The estimated quotient is either exact or one too small, since the
+ * reciprocal is at most one less than 2^64 divided by the divisor.
+ */
+static uint64_t cycle_ratio_div(const struct cycle_ratio *ratio,
+	uint64_t n, uint64_t *r)
+{
+	uint64_t q = mul_hi_u64(n, ratio->reciprocal);
+
+	*r = n - q * ratio->from_frequency;
+	if (*r >= ratio->from_frequency) {
+		*r -= ratio->from_frequency;
+		q++;
+	}
+
+	return q;
+}
+
+uint64_t cycle_ratio_transform(const struct cycle_ratio *ratio, uint64_t cycle)
+{
+	if (ratio->from_frequency == 1)
+		return cycle * ratio->to_frequency;
+
+	uint64_t r, s;
+	const uint64_t q = cycle_ratio_div(ratio, cycle, &r);
+
+	return q * ratio->to_frequency +
+		cycle_ratio_div(ratio, r * ratio->to_frequency, &s);
+}
+
+uint64_t cycle_ratio_transform_align(const struct cycle_ratio *ratio,
+	uint64_t cycle)
+{
+	if (ratio->from_frequency == 1)
+		return cycle * ratio->to_frequency;
+
+	uint64_t r, s;
+	const uint64_t q = cycle_ratio_div(ratio, cycle, &r);
+
+	return q * ratio->to_frequency +
+		cycle_ratio_div(ratio, r * ratio->to_frequency +
+			ratio->from_frequency - 1, &s);
+}
+
 uint64_t machine_cycle(struct machine *machine)
 {
 	return machine->cycle + cpu_cycles_run(machine);
@@ -67,8 +146,6 @@ void atari_st_init(struct machine *machine,
 	const struct machine_registers *regs,
 	const struct machine_ports *ports)
 {
-	const uint8_t *p = prg;
-
 	machine->cycle = 0;
 	m68k_clear_timeslice(&machine->cpu.m68k);
 
@@ -84,10 +161,10 @@ void atari_st_init(struct machine *machine,
 	m68k_set_reg(&machine->cpu.m68k, M68K_REG_##label_##index_, regs->field_[index_]);
 	MACHINE_REGISTERS(MACHINE_REGISTER_SET)
 
-	for (size_t i = 0; i < size; i++)
-		ram_device.wr_u8(machine, &ram_device, offset + i, p[i]);
+	ram_device.wr(machine, &ram_device, offset, prg, size);
 
 	psg_sample(machine, ports->psg_sample, ports->arg);
+	psg_capture(machine, ports->psg_register, ports->arg);
 	sound_sample(machine, ports->sound_sample, ports->arg);
 	mixer_sample(machine, ports->mixer_sample, ports->arg);
 	record_sample(machine, ports->record_sample, ports->arg);
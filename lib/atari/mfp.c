@@ -143,6 +143,7 @@ static void mfp_reset(struct machine *machine, const struct device *device)
 
 const struct device mfp_device = {
 	.name = "mfp",
+	.slot = DEVICE_SLOT_MFP,
 	.clk = {
 		.frequency = MFP_FREQUENCY,
 		.divisor = 1
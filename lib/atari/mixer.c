@@ -282,6 +282,7 @@ void mixer_sample(struct machine *machine,
 
 const struct device mixer_device = {
 	.name = "mixer",
+	.slot = DEVICE_SLOT_MIXER,
 	.clk = {
 		.frequency = MIXER_FREQUENCY,
 		.divisor = 1
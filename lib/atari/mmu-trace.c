@@ -5,16 +5,67 @@
 
 #include <inttypes.h>
 #include <stdio.h>
-#include <string.h>
 
+#include "internal/macro.h"
 #include "internal/types.h"
 
 #include "atari/bus.h"
 #include "atari/machine.h"
+#include "atari/mmu-trace.h"
 #include "atari/trace.h"
 
+static const struct {
+	uint32_t m;
+	enum device_slot slot;
+} trace_device_slot[] = {
+	{ TRACE_DEVICE_PSG, DEVICE_SLOT_PSG   },
+	{ TRACE_DEVICE_SND, DEVICE_SLOT_SOUND },
+	{ TRACE_DEVICE_MFP, DEVICE_SLOT_MFP   },
+	{ TRACE_DEVICE_RAM, DEVICE_SLOT_RAM   },
+	{ TRACE_DEVICE_ROM, DEVICE_SLOT_ROM   },
+};
+
+void mmu_trace_mode(struct machine *machine, struct trace_mode *trace)
+{
+	machine->trace = trace && trace->m != TRACE_DEVICE_NONE ? trace : NULL;
+	machine->trace_device = 0;
+
+	if (!machine->trace)
+		return;
+
+	for (size_t i = 0; i < ARRAY_SIZE(trace_device_slot); i++)
+		if (trace->m & trace_device_slot[i].m)
+			machine->trace_device |= 1u << trace_device_slot[i].slot;
+}
+
+static bool mmu_traced(struct machine *machine,
+	uint32_t dev_address, const struct device *dev)
+{
+	if (dev == &bus_device_error)
+		return false;
+
+	return (machine->trace_device & (1u << dev->slot)) ||
+		(dev->bus.address + dev_address < 2048 &&
+		 TRACE_ENABLE(machine->trace, ZRO));
+}
+
+static void mmu_trace_binary(struct machine *machine,
+	uint8_t op, uint32_t dev_address, uint32_t value,
+	const struct device *dev)
+{
+	const struct trace_record record = {
+		.cycle = machine_cycle(machine),
+		.address = dev->bus.address + dev_address,
+		.value = value,
+		.op = op,
+		.slot = dev->slot,
+	};
+
+	fwrite(&record, sizeof(record), 1, machine->trace->file);
+}
+
 static void mmu_trace(struct machine *machine,
-	const char *op, uint32_t dev_address,
+	uint8_t binary_op, const char *op, uint32_t dev_address,
 	const char *spacing, int size, uint32_t value,
 	size_t (*sh)(struct machine *machine,
 		const struct device *device,
@@ -23,27 +74,14 @@ static void mmu_trace(struct machine *machine,
 {
 	char description[256];
 
-	if (!machine->trace || machine->trace->m == TRACE_DEVICE_NONE)
+	if (!mmu_traced(machine, dev_address, dev))
+		return;
+
+	if (machine->trace->format == TRACE_FORMAT_BINARY) {
+		mmu_trace_binary(machine, binary_op, dev_address, value, dev);
 		return;
+	}
 
-	if (strcmp(dev->name, "dma") == 0 && TRACE_ENABLE(machine->trace, DMA))
-		goto trace;
-	if (strcmp(dev->name, "psg") == 0 && TRACE_ENABLE(machine->trace, PSG))
-		goto trace;
-	if (strcmp(dev->name, "snd") == 0 && TRACE_ENABLE(machine->trace, SND))
-		goto trace;
-	if (strcmp(dev->name, "mfp") == 0 && TRACE_ENABLE(machine->trace, MFP))
-		goto trace;
-	if (strcmp(dev->name, "ram") == 0 && TRACE_ENABLE(machine->trace, RAM))
-		goto trace;
-	if (strcmp(dev->name, "rom") == 0 && TRACE_ENABLE(machine->trace, ROM))
-		goto trace;
-	if (dev->bus.address + dev_address < 2048 && TRACE_ENABLE(machine->trace, ZRO))
-		goto trace;
-
-	return;
-
-trace:
 	if (sh)
 		sh(machine, dev, dev_address, description, sizeof(description));
 	else
@@ -64,26 +102,30 @@ trace:
 			op, spacing, size, value);
 }
 
-void mmu_trace_rd_u8(struct machine *machine,
+void mmu_trace_rd_u8__(struct machine *machine,
 	uint32_t dev_address, uint32_t value, const struct device *dev)
 {
-	mmu_trace(machine, "rd  u8", dev_address, "  ", 2, value, dev->id_u8, dev);
+	mmu_trace(machine, 0, "rd  u8", dev_address, "  ", 2, value,
+		dev->id_u8, dev);
 }
 
-void mmu_trace_rd_u16(struct machine *machine,
+void mmu_trace_rd_u16__(struct machine *machine,
 	uint32_t dev_address, uint32_t value, const struct device *dev)
 {
-	mmu_trace(machine, "rd u16", dev_address, "", 4, value, dev->id_u16, dev);
+	mmu_trace(machine, TRACE_OP_U16, "rd u16", dev_address, "", 4, value,
+		dev->id_u16, dev);
 }
 
-void mmu_trace_wr_u8(struct machine *machine,
+void mmu_trace_wr_u8__(struct machine *machine,
 	uint32_t dev_address, uint32_t value, const struct device *dev)
 {
-	mmu_trace(machine, "wr  u8", dev_address, "  ", 2, value, dev->id_u8, dev);
+	mmu_trace(machine, TRACE_OP_WR, "wr  u8", dev_address, "  ", 2, value,
+		dev->id_u8, dev);
 }
 
-void mmu_trace_wr_u16(struct machine *machine,
+void mmu_trace_wr_u16__(struct machine *machine,
 	uint32_t dev_address, uint32_t value, const struct device *dev)
 {
-	mmu_trace(machine, "wr u16", dev_address, "", 4, value, dev->id_u16, dev);
+	mmu_trace(machine, TRACE_OP_WR | TRACE_OP_U16, "wr u16", dev_address,
+		"", 4, value, dev->id_u16, dev);
 }
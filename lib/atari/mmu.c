@@ -4,6 +4,7 @@
  */
 
 #include "internal/macro.h"
+#include "internal/stats.h"
 #include "internal/types.h"
 
 #include "atari/bus.h"
@@ -37,6 +38,59 @@ static void mmu_bus_wait(struct machine *machine, const struct device *dev)
 	}
 }
 
+static void mmu_stats(struct machine *machine, const struct device *dev)
+{
+	if (dev == &bus_device_error)
+		stats_inc(machine->stats.bus_error);
+	else
+		stats_inc(machine->stats.bus[dev->slot]);
+}
+
+/*
+ * RAM and ROM are by far the most common processor accesses, so they are
+ * made directly rather than through the device callbacks.
+ */
+
+static uint8_t mmu_rd_u8(struct machine *machine,
+	const struct device *dev, uint32_t dev_address)
+{
+	if (dev == &ram_device)
+		return ram_read_u8(machine, dev_address);
+	if (dev == &rom_device)
+		return rom_read_u8(dev_address);
+
+	return dev->rd_u8(machine, dev, dev_address);
+}
+
+static uint16_t mmu_rd_u16(struct machine *machine,
+	const struct device *dev, uint32_t dev_address)
+{
+	if (dev == &ram_device)
+		return ram_read_u16(machine, dev_address);
+	if (dev == &rom_device)
+		return rom_read_u16(dev_address);
+
+	return dev->rd_u16(machine, dev, dev_address);
+}
+
+static void mmu_wr_u8(struct machine *machine,
+	const struct device *dev, uint32_t dev_address, uint8_t data)
+{
+	if (dev == &ram_device)
+		ram_write_u8(machine, dev_address, data);
+	else
+		dev->wr_u8(machine, dev, dev_address, data);
+}
+
+static void mmu_wr_u16(struct machine *machine,
+	const struct device *dev, uint32_t dev_address, uint16_t data)
+{
+	if (dev == &ram_device)
+		ram_write_u16(machine, dev_address, data);
+	else
+		dev->wr_u16(machine, dev, dev_address, data);
+}
+
 #define DMA_DEVICE(bus_address, dev)					\
 	valid_device_bus_address(bus_address, dev) ? dev
 #define DMA_DEVICES(bus_address)					\
@@ -117,8 +171,9 @@ uint32_t m68k_read_memory_8(struct m68k_module *module, uint32_t bus_address)
 	const uint32_t dev_address = bus_address - dev->bus.address;
 
 	mmu_bus_wait(machine, dev);
+	mmu_stats(machine, dev);
 
-	const uint8_t value = dev->rd_u8(machine, dev, dev_address);
+	const uint8_t value = mmu_rd_u8(machine, dev, dev_address);
 
 	mmu_trace_rd_u8(machine, dev_address, value, dev);
 
@@ -130,15 +185,47 @@ uint32_t m68k_read_memory_16(struct m68k_module *module, uint32_t bus_address)
 	struct machine *machine = machine_from_m68k_module(module);
 	const struct device *dev = device_for_bus_address(machine, bus_address);
 	const uint32_t dev_address = bus_address - dev->bus.address;
-	const uint16_t value = dev->rd_u16(machine, dev, dev_address);
+	const uint16_t value = mmu_rd_u16(machine, dev, dev_address);
 
 	mmu_bus_wait(machine, dev);
+	mmu_stats(machine, dev);
 
 	mmu_trace_rd_u16(machine, dev_address, value, dev);
 
 	return value;
 }
 
+bool m68k_instruction_cacheable(struct m68k_module *module, uint32_t pc)
+{
+	struct machine *machine = machine_from_m68k_module(module);
+
+	/* The opcode and the first extension word must both be in RAM. */
+	if (device_for_bus_address(machine, pc) != &ram_device ||
+	    device_for_bus_address(machine, pc + 2) != &ram_device)
+		return false;
+
+	ram_cache_code(machine, pc);
+	ram_cache_code(machine, pc + 2);
+
+	return true;
+}
+
+void m68k_instruction_cache_read(struct m68k_module *module,
+	uint32_t bus_address)
+{
+	struct machine *machine = machine_from_m68k_module(module);
+
+	/*
+	 * Cached instructions are in RAM, so this is equivalent to
+	 * m68k_read_memory_16() except the value is already known.
+	 */
+	mmu_bus_wait(machine, &ram_device);
+	mmu_stats(machine, &ram_device);
+
+	mmu_trace_rd_u16(machine, bus_address,
+		ram_read_u16(machine, bus_address), &ram_device);
+}
+
 uint32_t m68k_read_memory_32(struct m68k_module *module, uint32_t bus_address)
 {
 	const uint32_t hi = m68k_read_memory_16(module, bus_address);
@@ -154,10 +241,11 @@ void m68k_write_memory_8(struct m68k_module *module, uint32_t bus_address, uint3
 	const uint32_t dev_address = bus_address - dev->bus.address;
 
 	mmu_bus_wait(machine, dev);
+	mmu_stats(machine, dev);
 
 	mmu_trace_wr_u8(machine, dev_address, value, dev);
 
-	dev->wr_u8(machine, dev, dev_address, value & 0xff);
+	mmu_wr_u8(machine, dev, dev_address, value & 0xff);
 }
 
 void m68k_write_memory_16(struct m68k_module *module, uint32_t bus_address, uint32_t value)
@@ -167,10 +255,11 @@ void m68k_write_memory_16(struct m68k_module *module, uint32_t bus_address, uint
 	const uint32_t dev_address = bus_address - dev->bus.address;
 
 	mmu_bus_wait(machine, dev);
+	mmu_stats(machine, dev);
 
 	mmu_trace_wr_u16(machine, dev_address, value, dev);
 
-	dev->wr_u16(machine, dev, dev_address, value & 0xffff);
+	mmu_wr_u16(machine, dev, dev_address, value & 0xffff);
 }
 
 void m68k_write_memory_32(struct m68k_module *module, uint32_t bus_address, uint32_t value)
@@ -185,7 +274,7 @@ uint32_t m68k_read_disassembler_16(struct m68k_module *module, uint32_t bus_addr
 	const struct device *dev = device_for_bus_address(machine, bus_address);
 	const uint32_t dev_address = bus_address - dev->bus.address;
 
-	return dev->rd_u16(machine, dev, dev_address);
+	return mmu_rd_u16(machine, dev, dev_address);
 }
 
 uint32_t m68k_read_disassembler_32(struct m68k_module *module, uint32_t bus_address)
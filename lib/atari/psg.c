@@ -115,6 +115,10 @@ static void psg_wr_u8(struct machine *machine, const struct device *device,
 		cf2149->port.bdc(cf2149, cycle,
 			(struct cf2149_bdc) { .u8 = CF2149_BDC_DWS });
 		cf2149->port.wr_da(cf2149, cycle, data);
+		if (machine->psg.output.capture && cf2149->state.reg < 16)
+			machine->psg.output.capture(psg_cycle.c,
+				cf2149->state.reg, data,
+				machine->psg.output.capture_arg);
 		break;
 #if 0  /* FIXME: Dependency on pr_bug */
 	default:
@@ -180,8 +184,16 @@ void psg_sample(struct machine *machine,
 	machine->psg.output.sample_arg = sample_arg;
 }
 
+void psg_capture(struct machine *machine,
+	psg_register_f capture, void *capture_arg)
+{
+	machine->psg.output.capture = capture;
+	machine->psg.output.capture_arg = capture_arg;
+}
+
 const struct device psg_device = {
 	.name = "psg",
+	.slot = DEVICE_SLOT_PSG,
 	.clk = {
 		.frequency = PSG_FREQUENCY,
 		.divisor = 1
@@ -15,6 +15,8 @@
 #include "atari/sound.h"
 #include "atari/system-variable.h"
 
+#include "m68k/m68k.h"
+
 #include "tos/tos.h"
 
 struct ram_map_ro ram_map_ro(struct machine *machine,
@@ -32,38 +34,79 @@ struct ram_map_ro ram_map_ro(struct machine *machine,
 
 static void ram_reset(struct machine *machine, const struct device *device)
 {
+	for (uint32_t page = 0; page < MACHINE_RAM_PAGE_COUNT; page++)
+		if (machine->ram.dirty[page / 32] & (1u << (page % 32)))
+			memset(&machine->ram.u8[page << MACHINE_RAM_PAGE_SHIFT],
+				0, 1 << MACHINE_RAM_PAGE_SHIFT);
+	memset(machine->ram.dirty, 0, sizeof(machine->ram.dirty));
+
+	m68k_instruction_cache_flush(&machine->cpu.m68k);
+	memset(machine->ram.code, 0, sizeof(machine->ram.code));
+
 	memcpy(&machine->ram.u8[0], tos, 8);	/* ROM overlay during reset */
-	memset(&machine->ram.u8[8], 0, sizeof(machine->ram.u8) - 8);
+	ram_dirty(machine, 0);
 }
 
 static uint8_t ram_rd_u8(struct machine *machine, const struct device *device,
 	uint32_t dev_address)
 {
-	return machine->ram.u8[dev_address];
+	return ram_read_u8(machine, dev_address);
 }
 
 static uint16_t ram_rd_u16(struct machine *machine, const struct device *device,
 	uint32_t dev_address)
 {
-	return (machine->ram.u8[dev_address] << 8) |
-		machine->ram.u8[dev_address + 1];
+	return ram_read_u16(machine, dev_address);
 }
 
 static void ram_wr_u8(struct machine *machine, const struct device *device,
 	uint32_t dev_address, uint8_t data)
 {
-	sound_check(machine, dev_address);
-
-	machine->ram.u8[dev_address] = data;
+	ram_write_u8(machine, dev_address, data);
 }
 
 static void ram_wr_u16(struct machine *machine, const struct device *device,
 	uint32_t dev_address, uint16_t data)
 {
-	sound_check(machine, dev_address);
+	ram_write_u16(machine, dev_address, data);
+}
+
+/*
+ * Bulk writes are a memcpy, with the per-byte checks for DMA sound and
+ * cached instructions made only for pages that need them.
+ */
+static void ram_wr(struct machine *machine, const struct device *device,
+	uint32_t dev_address, const void *data, size_t size)
+{
+	if (ARRAY_SIZE(machine->ram.u8) <= dev_address || !size)
+		return;
+
+	size = min_t(size_t, size, ARRAY_SIZE(machine->ram.u8) - dev_address);
+
+	const uint32_t first = dev_address >> MACHINE_RAM_PAGE_SHIFT;
+	const uint32_t last = (dev_address + size - 1) >> MACHINE_RAM_PAGE_SHIFT;
+	bool code = false;
+
+	for (uint32_t page = first; page <= last; page++) {
+		const uint32_t page_address = page << MACHINE_RAM_PAGE_SHIFT;
+
+		if (sound_watched(machine, page_address)) {
+			const uint32_t start = max(dev_address, page_address);
+			const uint32_t end = min_t(uint32_t, dev_address + size,
+				page_address + (1 << MACHINE_RAM_PAGE_SHIFT));
+
+			for (uint32_t a = start; a < end; a++)
+				sound_check(machine, a);
+		}
+
+		code = code || ram_code_cached(machine, page_address);
+		ram_dirty(machine, page_address);
+	}
+
+	if (code)
+		m68k_instruction_cache_flush(&machine->cpu.m68k);
 
-	machine->ram.u8[dev_address] = data >> 8;
-	machine->ram.u8[dev_address + 1] = data & 0xff;
+	memcpy(&machine->ram.u8[dev_address], data, size);
 }
 
 static size_t ram_id_u8(struct machine *machine,
@@ -87,6 +130,7 @@ static size_t ram_id_u16(struct machine *machine,
 
 const struct device ram_device = {
 	.name = "ram",
+	.slot = DEVICE_SLOT_RAM,
 	.clk = {
 		.frequency = CPU_FREQUENCY,
 		.divisor = 1
@@ -101,6 +145,7 @@ const struct device ram_device = {
 	.rd_u16 = ram_rd_u16,
 	.wr_u8  = ram_wr_u8,
 	.wr_u16 = ram_wr_u16,
+	.wr     = ram_wr,
 	.id_u8  = ram_id_u8,
 	.id_u16 = ram_id_u16,
 };
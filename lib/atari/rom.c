@@ -10,21 +10,32 @@
 
 #include "tos/tos.h"
 
+uint8_t rom_read_u8(uint32_t dev_address)
+{
+	return dev_address + 1 <= sizeof(tos) ? tos[dev_address] : 0;
+}
+
+uint16_t rom_read_u16(uint32_t dev_address)
+{
+	return dev_address + 2 <= sizeof(tos) ?
+		(tos[dev_address] << 8) | tos[dev_address + 1] : 0;
+}
+
 static uint8_t rom_rd_u8(struct machine *machine, const struct device *device,
 	uint32_t dev_address)
 {
-	return dev_address + 1 <= sizeof(tos) ? tos[dev_address] : 0;
+	return rom_read_u8(dev_address);
 }
 
 static uint16_t rom_rd_u16(struct machine *machine, const struct device *device,
 	uint32_t dev_address)
 {
-	return dev_address + 2 <= sizeof(tos) ?
-		(tos[dev_address] << 8) | tos[dev_address + 1] : 0;
+	return rom_read_u16(dev_address);
 }
 
 const struct device rom_device = {
 	.name = "rom",
+	.slot = DEVICE_SLOT_ROM,
 	.clk = {
 		.frequency = CPU_FREQUENCY,
 		.divisor = 1
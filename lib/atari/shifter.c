@@ -73,6 +73,7 @@ static void shifter_reset(struct machine *machine, const struct device *device)
 
 const struct device shifter_device = {
 	.name = "shifter",
+	.slot = DEVICE_SLOT_SHIFTER,
 	.clk = {
 		.frequency = ATARI_STE_PAL_MCLK,
 		.divisor = 1
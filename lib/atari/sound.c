@@ -11,6 +11,7 @@
 
 #include "internal/compare.h"
 #include "internal/macro.h"
+#include "internal/stats.h"
 
 #include "atari/bus.h"
 #include "atari/device.h"
@@ -27,6 +28,9 @@
 #define SOUND_EVENT_FREQUENCY 100		/* 10 ms */
 #define SOUND_EVENT_CYCLES (SOUND_FREQUENCY / SOUND_EVENT_FREQUENCY)
 
+#define SOUND_REG_FRAME_START 1	/* 0xff8903, high byte first */
+#define SOUND_REG_FRAME_END   7	/* 0xff890f, high byte first */
+
 static char *sound_register_name(uint32_t reg)
 {
 	switch (reg) {
@@ -44,6 +48,53 @@ static inline struct cf300588_sound_cycle cf300588_sound_cycle_from_device(
 	return cf300588_sound_cycle_cd(cycle.c, 1 /* FIXME */);
 }
 
+static uint32_t sound_frame_address(struct cf300588_sound_module *cf300588,
+	struct cf300588_sound_cycle module_cycle, uint32_t reg)
+{
+	return (cf300588->port.rd_da(cf300588, module_cycle, reg) << 16) |
+	       (cf300588->port.rd_da(cf300588, module_cycle, reg + 1) << 8) |
+		cf300588->port.rd_da(cf300588, module_cycle, reg + 2);
+}
+
+static void sound_watch_range(struct machine *machine,
+	uint32_t addr, uint32_t end)
+{
+	end = min_t(uint32_t, end, ARRAY_SIZE(machine->ram.u8));
+
+	if (end <= addr)
+		return;
+
+	for (uint32_t page = addr >> MACHINE_RAM_PAGE_SHIFT;
+	     page <= (end - 1) >> MACHINE_RAM_PAGE_SHIFT;
+	     page++)
+		machine->sound.watch[page / 32] |= 1u << (page % 32);
+}
+
+/*
+ * DMA sound fetches from the current DMA region, and continues with the
+ * frame given by the frame start and end registers when the region ends.
+ * RAM writes are checked only for the pages of these, which are updated
+ * whenever they may have changed, that is with every sound event and
+ * sound register write.
+ */
+static void sound_watch(struct machine *machine,
+	struct cf300588_sound_cycle module_cycle)
+{
+	struct cf300588_sound_module *cf300588 = &machine->sound.cf300588;
+	const struct cf300588_sound_dma_region dma_region =
+		cf300588->port.dma(cf300588);
+
+	memset(machine->sound.watch, 0, sizeof(machine->sound.watch));
+
+	sound_watch_range(machine, dma_region.addr,
+		dma_region.addr + dma_region.size);
+	sound_watch_range(machine,
+		sound_frame_address(cf300588, module_cycle,
+			SOUND_REG_FRAME_START),
+		sound_frame_address(cf300588, module_cycle,
+			SOUND_REG_FRAME_END));
+}
+
 static void request_event(struct machine *machine, const struct device *device,
 	struct device_cycle sound_cycle, struct cf300588_sound_event event)
 {
@@ -62,6 +113,20 @@ static void request_event(struct machine *machine, const struct device *device,
 	dma_sound_active(machine, event.sint.active);
 }
 
+#ifdef HAVE_STATS
+/*
+ * The DMA region begins with the frame address counter, so it advances
+ * with every byte fetched, until the end of the frame where it restarts.
+ */
+static void sound_stats(struct machine *machine,
+	const struct cf300588_sound_dma_region prev,
+	const struct cf300588_sound_dma_region next)
+{
+	stats_add(machine->stats.dma_sound_bytes,
+		prev.addr <= next.addr ? next.addr - prev.addr : prev.size);
+}
+#endif
+
 static void sound_event(struct machine *machine, const struct device *device,
 	const struct device_cycle sound_cycle)
 {
@@ -100,6 +165,12 @@ static void sound_event(struct machine *machine, const struct device *device,
 					machine->sound.output.sample_arg);
 		}
 
+#ifdef HAVE_STATS
+	sound_stats(machine, dma_region, cf300588->port.dma(cf300588));
+#endif
+
+	sound_watch(machine, module_cycle);
+
 	request_event(machine, device, sound_cycle,
 		cf300588->port.event(cf300588, module_cycle));
 }
@@ -147,6 +218,8 @@ static void sound_wr_u8(struct machine *machine, const struct device *device,
 
 	request_event(machine, device, sound_cycle,
 		cf300588->port.wr_da(cf300588, module_cycle, reg, val));
+
+	sound_watch(machine, module_cycle);
 }
 
 static void sound_wr_u16(struct machine *machine, const struct device *device,
@@ -185,6 +258,8 @@ static void sound_reset(struct machine *machine, const struct device *device)
 
 	*cf300588 = cf300588_sound_init(module_cycle);
 
+	sound_watch(machine, module_cycle);
+
 	request_event(machine, device, sound_cycle,
 			(struct cf300588_sound_event) { });
 }
@@ -218,6 +293,7 @@ void sound_check(struct machine *machine, uint32_t bus_address)
 
 const struct device sound_device = {
 	.name = "snd",
+	.slot = DEVICE_SLOT_SOUND,
 	.clk = {
 		.frequency = SOUND_FREQUENCY,
 		.divisor = 1
@@ -92,30 +92,45 @@ static void alsa_sample_flush(struct alsa_state *state)
 	}
 }
 
-static bool alsa_sample(int16_t left, int16_t right, void *arg)
+static size_t alsa_write(const struct psgplay_stereo *buffer, size_t count,
+	void *arg)
 {
 	struct alsa_state *state = arg;
+	size_t n = 0;
 
-	if (fifo_full(&state->fifo)) {
-		alsa_sample_flush(state);
+	while (n < count) {
+		struct alsa_stereo_sample *stereo_sample;
+		const size_t r = fifo_reserve(&state->fifo,
+			(void **)&stereo_sample) / sizeof(*stereo_sample);
 
-		return false;
-	}
+		if (!r) {
+			alsa_sample_flush(state);
 
-	const struct alsa_stereo_sample stereo_sample = {
-		.left  = ALSA_SAMPLE(left),
-		.right = ALSA_SAMPLE(right)
-	};
+			break;
+		}
 
-	const size_t w = fifo_write(&state->fifo,
-		&stereo_sample, sizeof(stereo_sample));
+		const size_t m = min(r, count - n);
 
-	BUG_ON(w != sizeof(stereo_sample));
+		for (size_t i = 0; i < m; i++, n++)
+			stereo_sample[i] = (struct alsa_stereo_sample) {
+				.left  = ALSA_SAMPLE(buffer[n].left),
+				.right = ALSA_SAMPLE(buffer[n].right)
+			};
 
-	if (fifo_full(&state->fifo))
-		alsa_sample_flush(state);
+		fifo_commit(&state->fifo, m * sizeof(*stereo_sample));
 
-	return true;
+		if (fifo_full(&state->fifo))
+			alsa_sample_flush(state);
+	}
+
+	return n;
+}
+
+static bool alsa_sample(int16_t left, int16_t right, void *arg)
+{
+	const struct psgplay_stereo stereo = { .left = left, .right = right };
+
+	return alsa_write(&stereo, 1, arg) == 1;
 }
 
 static bool alsa_pause(void *arg)
@@ -267,7 +282,7 @@ static void *alsa_open(const char *output, int frequency,
 	return state;
 }
 
-static void alsa_close(void *arg)
+static bool alsa_close(void *arg)
 {
 	struct alsa_state *state = arg;
 
@@ -277,6 +292,8 @@ static void alsa_close(void *arg)
 	snd_pcm_close(state->pcm_handle);
 
 	free(state);
+
+	return true;
 }
 
 #endif /* HAVE_ALSA */
@@ -291,6 +308,7 @@ const struct audio_writer alsa_writer = {
 #ifdef HAVE_ALSA
 	.open	= alsa_open,
 	.sample	= alsa_sample,
+	.write	= alsa_write,
 	.pause	= alsa_pause,
 	.resume	= alsa_resume,
 	.flush	= alsa_flush,
@@ -91,29 +91,45 @@ again:;	/* Label followed by a declaration is a C23 extension. */
 	fifo_skip(&state->fifo, available_frames * sizeof(*buffer));
 }
 
-static bool portaudio_sample(int16_t left, int16_t right, void *arg)
+static size_t portaudio_write(const struct psgplay_stereo *buffer, size_t count,
+	void *arg)
 {
 	struct portaudio_state *state = arg;
+	size_t n = 0;
 
-	if (fifo_full(&state->fifo)) {
-		portaudio_sample_flush(state);
-		return false;
-	}
+	while (n < count) {
+		struct portaudio_stereo_sample *stereo_sample;
+		const size_t r = fifo_reserve(&state->fifo,
+			(void **)&stereo_sample) / sizeof(*stereo_sample);
 
-	const struct portaudio_stereo_sample stereo_sample = {
-		.left  = PORTAUDIO_SAMPLE(left),
-		.right = PORTAUDIO_SAMPLE(right)
-	};
+		if (!r) {
+			portaudio_sample_flush(state);
 
-	const size_t w = fifo_write(&state->fifo,
-		&stereo_sample, sizeof(stereo_sample));
+			break;
+		}
 
-	BUG_ON(w != sizeof(stereo_sample));
+		const size_t m = min(r, count - n);
 
-	if (fifo_full(&state->fifo))
-		portaudio_sample_flush(state);
+		for (size_t i = 0; i < m; i++, n++)
+			stereo_sample[i] = (struct portaudio_stereo_sample) {
+				.left  = PORTAUDIO_SAMPLE(buffer[n].left),
+				.right = PORTAUDIO_SAMPLE(buffer[n].right)
+			};
 
-	return true;
+		fifo_commit(&state->fifo, m * sizeof(*stereo_sample));
+
+		if (fifo_full(&state->fifo))
+			portaudio_sample_flush(state);
+	}
+
+	return n;
+}
+
+static bool portaudio_sample(int16_t left, int16_t right, void *arg)
+{
+	const struct psgplay_stereo stereo = { .left = left, .right = right };
+
+	return portaudio_write(&stereo, 1, arg) == 1;
 }
 
 static bool portaudio_pause(void *arg)
@@ -220,7 +236,7 @@ error:
 	pr_fatal_error("Error initializing PortAudio: %s\n", Pa_GetErrorText(err));
 }
 
-static void portaudio_close(void *arg)
+static bool portaudio_close(void *arg)
 {
 	struct portaudio_state *state = arg;
 	PaError err;
@@ -237,7 +253,7 @@ static void portaudio_close(void *arg)
 
 	err = Pa_Terminate();
 	if (err == paNoError)
-		return;
+		return true;
 
 error:
 	pr_fatal_error("Error shutting down PortAudio: %s\n", Pa_GetErrorText(err));
@@ -249,6 +265,7 @@ const struct audio_writer portaudio_output = {
 #ifdef HAVE_PORTAUDIO
 	.open	= portaudio_open,
 	.sample	= portaudio_sample,
+	.write	= portaudio_write,
 	.pause	= portaudio_pause,
 	.resume	= portaudio_resume,
 	.flush	= portaudio_flush,
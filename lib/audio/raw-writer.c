@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (C) 2026 Fredrik Noring
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "internal/assert.h"
+#include "internal/compare.h"
+#include "internal/print.h"
+
+#include "audio/raw-writer.h"
+
+#include "system/unix/file.h"
+#include "system/unix/memory.h"
+
+struct raw_sample {
+	uint8_t lo;
+	int8_t hi;
+};
+
+struct raw_state {
+	const char *output;
+	int fd;
+
+	bool fatal;
+	bool error;
+
+	size_t sample_count;
+	size_t sample_length;
+
+	size_t buffer_count;
+	struct {
+		struct raw_sample left;
+		struct raw_sample right;
+	} buffer[16384];
+};
+
+#define RAW_SAMPLE(s) ((struct raw_sample) { .lo = (s),.hi = (s) >> 8 })
+
+/* Report a failed write, and exit unless the writer is nonfatal. */
+static bool raw_error(struct raw_state *state, ssize_t size)
+{
+	if (size == -1)
+		pr_errno(state->output);
+	else
+		pr_error("%s: Failed to write complete raw samples\n",
+			state->output);
+
+	if (state->fatal)
+		exit(EXIT_FAILURE);
+
+	state->error = true;
+
+	return false;
+}
+
+static bool raw_sample_flush(struct raw_state *state)
+{
+	const size_t buffer_size = state->buffer_count * sizeof(*state->buffer);
+	const ssize_t size = xwrite(state->fd, state->buffer, buffer_size);
+
+	BUG_ON(4 * ARRAY_SIZE(state->buffer) != sizeof(state->buffer));
+
+	state->buffer_count = 0;
+
+	return size == buffer_size || raw_error(state, size);
+}
+
+static size_t raw_write(const struct psgplay_stereo *buffer, size_t count,
+	void *arg)
+{
+	struct raw_state *state = arg;
+
+	if (state->error)
+		return 0;
+
+	/* Ignore samples beyond given length, if any */
+	const size_t n = !state->sample_length ? count : min(count,
+		state->sample_length - state->sample_count);
+
+	state->sample_count += n;
+
+	for (size_t i = 0; i < n; ) {
+		const size_t m = min(n - i,
+			ARRAY_SIZE(state->buffer) - state->buffer_count);
+
+		for (size_t k = 0; k < m; k++, i++) {
+			state->buffer[state->buffer_count + k].left =
+				RAW_SAMPLE(buffer[i].left);
+			state->buffer[state->buffer_count + k].right =
+				RAW_SAMPLE(buffer[i].right);
+		}
+
+		state->buffer_count += m;
+
+		if (state->buffer_count == ARRAY_SIZE(state->buffer) &&
+		    !raw_sample_flush(state))
+			return 0;
+	}
+
+	return count;
+}
+
+static bool raw_sample(int16_t left, int16_t right, void *arg)
+{
+	const struct psgplay_stereo stereo = { .left = left, .right = right };
+
+	return raw_write(&stereo, 1, arg) == 1;
+}
+
+static void *raw_open_(const char *output, size_t sample_length, bool fatal)
+{
+	struct raw_state *state = xmalloc(sizeof(struct raw_state));
+
+	*state = (struct raw_state) {
+		.output = output,
+		.fd = xopen(output, O_WRONLY | O_CREAT | O_TRUNC, 0644),
+		.fatal = fatal,
+		.sample_length = sample_length,
+	};
+
+	if (state->fd == -1) {
+		raw_error(state, -1);
+		free(state);
+		return NULL;
+	}
+
+	return state;
+}
+
+static void *raw_open(const char *output, int frequency,
+	bool nonblocking, size_t sample_length)
+{
+	return raw_open_(output, sample_length, true);
+}
+
+static void *raw_open_nonfatal(const char *output, int frequency,
+	bool nonblocking, size_t sample_length)
+{
+	return raw_open_(output, sample_length, false);
+}
+
+static bool raw_close(void *arg)
+{
+	struct raw_state *state = arg;
+
+	while (state->sample_count < state->sample_length)
+		if (!raw_sample(0, 0, arg))  /* Pad until given sample length */
+			break;
+
+	bool ok = !state->error && raw_sample_flush(state);
+
+	if (xclose(state->fd) == -1)
+		ok = raw_error(state, -1);
+
+	free(state);
+
+	return ok;
+}
+
+const struct audio_writer raw_writer = {
+	.open	= raw_open,
+	.sample	= raw_sample,
+	.write	= raw_write,
+	.close	= raw_close,
+};
+
+const struct audio_writer raw_writer_nonfatal = {
+	.open	= raw_open_nonfatal,
+	.sample	= raw_sample,
+	.write	= raw_write,
+	.close	= raw_close,
+};
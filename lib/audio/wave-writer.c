@@ -31,6 +31,9 @@ struct wave_state {
 	const char *output;
 	int fd;
 
+	bool fatal;
+	bool error;
+
 	int frequency;
 
 	size_t sample_count;
@@ -70,7 +73,25 @@ struct wave_data {
 	wave_u32 cksize;		/* File size - 44 */
 };
 
-static void wave_write_header(int fd, const char *output,
+/* Report a failed write, and exit unless the writer is nonfatal. */
+static bool wave_error(struct wave_state *state, ssize_t size,
+	const char *what)
+{
+	if (size == -1)
+		pr_errno(state->output);
+	else
+		pr_error("%s: Failed to write complete WAVE %s\n",
+			state->output, what);
+
+	if (state->fatal)
+		exit(EXIT_FAILURE);
+
+	state->error = true;
+
+	return false;
+}
+
+static bool wave_write_header(struct wave_state *state,
 	int frequency, size_t sample_length)
 {
 	const size_t total_size =
@@ -107,12 +128,11 @@ static void wave_write_header(int fd, const char *output,
 	BUILD_BUG_ON(sizeof(wave_header) != 44);
 	BUG_ON((uint32_t)total_size != total_size);
 
-	const ssize_t size = xwrite(fd, &wave_header, sizeof(wave_header));
-	if (size == -1)
-		pr_fatal_errno(output);
-	else if (size != sizeof(wave_header))
-		pr_fatal_error("%s: Failed to write complete WAVE header\n",
-			output);
+	const ssize_t size = xwrite(state->fd,
+		&wave_header, sizeof(wave_header));
+
+	return size == sizeof(wave_header) ||
+		wave_error(state, size, "header");
 }
 
 static bool wave_sample_flush(struct wave_state *state)
@@ -124,36 +144,53 @@ static bool wave_sample_flush(struct wave_state *state)
 
 	state->buffer_count = 0;
 
-	if (size == -1)
-		pr_fatal_errno(state->output);
-	else if (size != buffer_size)
-		pr_fatal_error("%s: Failed to write complete WAVE samples\n",
-			state->output);
-
-	return true;
+	return size == buffer_size || wave_error(state, size, "samples");
 }
 
-static bool wave_sample(int16_t left, int16_t right, void *arg)
+static size_t wave_write(const struct psgplay_stereo *buffer, size_t count,
+	void *arg)
 {
 	struct wave_state *state = arg;
 
-	if (state->sample_count >= state->sample_length)
-		return true;	/* Ignore samples beyond given length */
+	if (state->error)
+		return 0;
+
+	/* Ignore samples beyond given length */
+	const size_t n = min(count,
+		state->sample_length - state->sample_count);
 
-	state->sample_count++;
+	state->sample_count += n;
 
-	state->buffer[state->buffer_count].left  = WAVE_SAMPLE(left);
-	state->buffer[state->buffer_count].right = WAVE_SAMPLE(right);
-	state->buffer_count++;
+	for (size_t i = 0; i < n; ) {
+		const size_t m = min(n - i,
+			ARRAY_SIZE(state->buffer) - state->buffer_count);
 
-	if (state->buffer_count < ARRAY_SIZE(state->buffer))
-		return true;
+		for (size_t k = 0; k < m; k++, i++) {
+			state->buffer[state->buffer_count + k].left =
+				WAVE_SAMPLE(buffer[i].left);
+			state->buffer[state->buffer_count + k].right =
+				WAVE_SAMPLE(buffer[i].right);
+		}
 
-	return wave_sample_flush(state);
+		state->buffer_count += m;
+
+		if (state->buffer_count == ARRAY_SIZE(state->buffer) &&
+		    !wave_sample_flush(state))
+			return 0;
+	}
+
+	return count;
 }
 
-static void *wave_open(const char *output, int frequency,
-	bool nonblocking, size_t sample_length)
+static bool wave_sample(int16_t left, int16_t right, void *arg)
+{
+	const struct psgplay_stereo stereo = { .left = left, .right = right };
+
+	return wave_write(&stereo, 1, arg) == 1;
+}
+
+static void *wave_open_(const char *output, int frequency,
+	size_t sample_length, bool fatal)
 {
 	if (!sample_length)
 		pr_fatal_error("%s: WAVE opened for writing without duration\n",
@@ -164,35 +201,66 @@ static void *wave_open(const char *output, int frequency,
 	*state = (struct wave_state) {
 		.output = output,
 		.fd = xopen(output, O_WRONLY | O_CREAT | O_TRUNC, 0644),
+		.fatal = fatal,
 		.frequency = frequency,
 		.sample_length = sample_length,
 	};
 
-	if (state->fd == -1)
-		pr_fatal_errno(output);
+	if (state->fd == -1) {
+		wave_error(state, -1, NULL);
+		free(state);
+		return NULL;
+	}
 
-	wave_write_header(state->fd, output, frequency, sample_length);
+	if (!wave_write_header(state, frequency, sample_length)) {
+		xclose(state->fd);
+		free(state);
+		return NULL;
+	}
 
 	return state;
 }
 
-static void wave_close(void *arg)
+static void *wave_open(const char *output, int frequency,
+	bool nonblocking, size_t sample_length)
+{
+	return wave_open_(output, frequency, sample_length, true);
+}
+
+static void *wave_open_nonfatal(const char *output, int frequency,
+	bool nonblocking, size_t sample_length)
+{
+	return wave_open_(output, frequency, sample_length, false);
+}
+
+static bool wave_close(void *arg)
 {
 	struct wave_state *state = arg;
 
 	while (state->sample_count < state->sample_length)
-		wave_sample(0, 0, arg);    /* Pad until given sample length */
+		if (!wave_sample(0, 0, arg))  /* Pad until given sample length */
+			break;
 
-	wave_sample_flush(state);
+	bool ok = !state->error && wave_sample_flush(state);
 
 	if (xclose(state->fd) == -1)
-		pr_fatal_errno(state->output);
+		ok = wave_error(state, -1, NULL);
 
 	free(state);
+
+	return ok;
 }
 
 const struct audio_writer wave_writer = {
 	.open	= wave_open,
 	.sample	= wave_sample,
+	.write	= wave_write,
+	.close	= wave_close,
+};
+
+const struct audio_writer wave_writer_nonfatal = {
+	.open	= wave_open_nonfatal,
+	.sample	= wave_sample,
+	.write	= wave_write,
 	.close	= wave_close,
 };
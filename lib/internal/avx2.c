@@ -0,0 +1,13 @@
+/* Test whether the compiler supports AVX2 functions selected at runtime. */
+#include <immintrin.h>
+
+__attribute__((__target__("avx2")))
+__m256i avx2(const int *base, __m256i index)
+{
+	return _mm256_i32gather_epi32(base, index, 4);
+}
+
+int avx2_supported(void)
+{
+	return __builtin_cpu_supports("avx2");
+}
@@ -81,3 +81,25 @@ size_t fifo_skip(struct fifo *f, size_t size)
 
 	return s;
 }
+
+size_t fifo_reserve(struct fifo *f, void **buf)
+{
+	const size_t i = f->index + f->size < f->capacity ?
+		f->index + f->size : f->index + f->size - f->capacity;
+	uint8_t *dst = f->buffer;
+
+	if (buf != NULL)
+		*buf = &dst[i];
+
+	return fifo_full(f) ? 0 :
+		i < f->index ? f->index - i : f->capacity - i;
+}
+
+size_t fifo_commit(struct fifo *f, size_t size)
+{
+	const size_t s = min(fifo_remaining(f), size);
+
+	f->size += s;
+
+	return s;
+}
@@ -76,6 +76,8 @@ M68KMAKE_PROTOTYPE_HEADER
 #ifndef M68KOPS__HEADER
 #define M68KOPS__HEADER
 
+#include "m68k/m68k.h"
+
 /* ======================================================================== */
 /* ============================ OPCODE HANDLERS =========================== */
 /* ======================================================================== */
@@ -87,8 +89,11 @@ M68KMAKE_PROTOTYPE_FOOTER
 
 struct m68k_module;
 
-/* Build the opcode handler table */
-void m68ki_build_opcode_table(struct m68k_module *module);
+/* Opcode handler jump table */
+extern void (*const m68ki_instruction_jump_table[0x10000])(struct m68k_module *module);
+
+/* Cycles used by CPU type */
+extern const unsigned char m68ki_cycles[M68KOPS_CPU_TYPES][0x10000];
 
 
 /* ======================================================================== */
@@ -103,143 +108,16 @@ XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
 M68KMAKE_TABLE_HEADER
 
 /* ======================================================================== */
-/* ========================= OPCODE TABLE BUILDER ========================= */
+/* ========================== OPCODE JUMP TABLE =========================== */
 /* ======================================================================== */
 
-#include <stdio.h>
 #include "m68k/m68kops.h"
 
-/* This is used to generate the opcode handler jump table */
-typedef struct
-{
-	void (*opcode_handler)(struct m68k_module *module);        /* handler function */
-	unsigned int  mask;                  /* mask on opcode */
-	unsigned int  match;                 /* what to match after masking */
-	unsigned char cycles[NUM_CPU_TYPES]; /* cycles each cpu type takes */
-} opcode_handler_struct;
-
-
-/* Opcode handler table */
-static const opcode_handler_struct m68k_opcode_handler_table[] =
-{
-/*   function                      mask    match    000  010  020  040 */
-
 
 
 XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
 M68KMAKE_TABLE_FOOTER
 
-	{0, 0, 0, {0, 0, 0, 0, 0}}
-};
-
-
-/* Build the opcode handler jump table */
-void m68ki_build_opcode_table(struct m68k_module *module)
-{
-	const opcode_handler_struct *ostruct;
-	int cycle_cost;
-	int instr;
-	int i;
-	int j;
-	int k;
-
-	for(i = 0; i < 0x10000; i++)
-	{
-		/* default to illegal */
-		module->m68ki_instruction_jump_table[i] = m68k_op_illegal;
-		for(k=0;k<NUM_CPU_TYPES;k++)
-			module->m68ki_cycles[k][i] = 0;
-	}
-
-	ostruct = m68k_opcode_handler_table;
-	while(ostruct->mask != 0xff00)
-	{
-		for(i = 0;i < 0x10000;i++)
-		{
-			if((i & ostruct->mask) == ostruct->match)
-			{
-				module->m68ki_instruction_jump_table[i] = ostruct->opcode_handler;
-				for(k=0;k<NUM_CPU_TYPES;k++)
-					module->m68ki_cycles[k][i] = ostruct->cycles[k];
-			}
-		}
-		ostruct++;
-	}
-	while(ostruct->mask == 0xff00)
-	{
-		for(i = 0;i <= 0xff;i++)
-		{
-			module->m68ki_instruction_jump_table[ostruct->match | i] = ostruct->opcode_handler;
-			for(k=0;k<NUM_CPU_TYPES;k++)
-				module->m68ki_cycles[k][ostruct->match | i] = ostruct->cycles[k];
-		}
-		ostruct++;
-	}
-	while(ostruct->mask == 0xf1f8)
-	{
-		for(i = 0;i < 8;i++)
-		{
-			for(j = 0;j < 8;j++)
-			{
-				instr = ostruct->match | (i << 9) | j;
-				module->m68ki_instruction_jump_table[instr] = ostruct->opcode_handler;
-				for(k=0;k<NUM_CPU_TYPES;k++)
-					module->m68ki_cycles[k][instr] = ostruct->cycles[k];
-				// For all shift operations with known shift distance (encoded in instruction word)
-				if((instr & 0xf000) == 0xe000 && (!(instr & 0x20)))
-				{
-					// On the 68000 and 68010 shift distance affect execution time.
-					// Add the cycle cost of shifting; 2 times the shift distance
-					cycle_cost = ((((i-1)&7)+1)<<1);
-					module->m68ki_cycles[0][instr] += cycle_cost;
-					module->m68ki_cycles[1][instr] += cycle_cost;
-					// On the 68020 shift distance does not affect execution time
-					module->m68ki_cycles[2][instr] += 0;
-				}
-			}
-		}
-		ostruct++;
-	}
-	while(ostruct->mask == 0xfff0)
-	{
-		for(i = 0;i <= 0x0f;i++)
-		{
-			module->m68ki_instruction_jump_table[ostruct->match | i] = ostruct->opcode_handler;
-			for(k=0;k<NUM_CPU_TYPES;k++)
-				module->m68ki_cycles[k][ostruct->match | i] = ostruct->cycles[k];
-		}
-		ostruct++;
-	}
-	while(ostruct->mask == 0xf1ff)
-	{
-		for(i = 0;i <= 0x07;i++)
-		{
-			module->m68ki_instruction_jump_table[ostruct->match | (i << 9)] = ostruct->opcode_handler;
-			for(k=0;k<NUM_CPU_TYPES;k++)
-				module->m68ki_cycles[k][ostruct->match | (i << 9)] = ostruct->cycles[k];
-		}
-		ostruct++;
-	}
-	while(ostruct->mask == 0xfff8)
-	{
-		for(i = 0;i <= 0x07;i++)
-		{
-			module->m68ki_instruction_jump_table[ostruct->match | i] = ostruct->opcode_handler;
-			for(k=0;k<NUM_CPU_TYPES;k++)
-				module->m68ki_cycles[k][ostruct->match | i] = ostruct->cycles[k];
-		}
-		ostruct++;
-	}
-	while(ostruct->mask == 0xffff)
-	{
-		module->m68ki_instruction_jump_table[ostruct->match] = ostruct->opcode_handler;
-		for(k=0;k<NUM_CPU_TYPES;k++)
-			module->m68ki_cycles[k][ostruct->match] = ostruct->cycles[k];
-		ostruct++;
-	}
-}
-
-
 /* ======================================================================== */
 /* ============================== END OF FILE ============================= */
 /* ======================================================================== */
@@ -10,11 +10,14 @@ struct m68k_module;
 extern void m68040_fpu_op0(void);
 extern void m68040_fpu_op1(void);
 extern void m68881_mmu_ops(void);
-extern void m68ki_build_opcode_table(struct m68k_module *module);
 
 #include "m68k/m68kops.h"
 #include "m68k/m68kcpu.h"
 
+#if !M68K_EMULATE_000_ONLY && M68KOPS_CPU_TYPES < NUM_CPU_TYPES
+#error "Opcode handlers generated for fewer CPU types than configured"
+#endif
+
 /* ======================================================================== */
 /* ================================= DATA ================================= */
 /* ======================================================================== */
@@ -74,7 +77,7 @@ const uint m68ki_shift_32_table[65] =
 /* Number of clock cycles to use for exception processing.
  * I used 4 for any vectors that are undocumented for processing times.
  */
-const uint8 m68ki_exception_cycle_table[5][256] =
+const uint8 m68ki_exception_cycle_table[][256] =
 {
 	{ /* 000 */
 		 40, /*  0: Reset - Initial Stack Pointer                      */
@@ -149,6 +152,7 @@ const uint8 m68ki_exception_cycle_table[5][256] =
 		  4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,
 		  4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4
 	},
+#if !M68K_EMULATE_000_ONLY
 	{ /* 010 */
 		 40, /*  0: Reset - Initial Stack Pointer                      */
 		  4, /*  1: Reset - Initial Program Counter                    */
@@ -441,6 +445,7 @@ const uint8 m68ki_exception_cycle_table[5][256] =
 		  4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,
 		  4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4
 	}
+#endif /* !M68K_EMULATE_000_ONLY */
 };
 
 const uint8 m68ki_ea_idx_cycle_table[64] =
@@ -712,7 +717,8 @@ void m68k_set_cpu_type(struct m68k_module *module, unsigned int cpu_type)
 			CPU_TYPE         = CPU_TYPE_000;
 			CPU_ADDRESS_MASK = 0x00ffffff;
 			CPU_SR_MASK      = 0xa71f; /* T1 -- S  -- -- I2 I1 I0 -- -- -- X  N  Z  V  C  */
-			CYC_INSTRUCTION  = module->m68ki_cycles[0];
+#if !M68K_EMULATE_000_ONLY
+			CYC_INSTRUCTION  = m68ki_cycles[0];
 			CYC_EXCEPTION    = m68ki_exception_cycle_table[0];
 			CYC_BCC_NOTAKE_B = -2;
 			CYC_BCC_NOTAKE_W = 2;
@@ -723,8 +729,10 @@ void m68k_set_cpu_type(struct m68k_module *module, unsigned int cpu_type)
 			CYC_MOVEM_L      = 3;
 			CYC_SHIFT        = 1;
 			CYC_RESET        = 132;
+#endif /* !M68K_EMULATE_000_ONLY */
 			HAS_PMMU	 = 0;
 			return;
+#if !M68K_EMULATE_000_ONLY
 		case M68K_CPU_TYPE_SCC68070:
 			m68k_set_cpu_type(module, M68K_CPU_TYPE_68010);
 			CPU_ADDRESS_MASK = 0xffffffff;
@@ -734,7 +742,7 @@ void m68k_set_cpu_type(struct m68k_module *module, unsigned int cpu_type)
 			CPU_TYPE         = CPU_TYPE_010;
 			CPU_ADDRESS_MASK = 0x00ffffff;
 			CPU_SR_MASK      = 0xa71f; /* T1 -- S  -- -- I2 I1 I0 -- -- -- X  N  Z  V  C  */
-			CYC_INSTRUCTION  = module->m68ki_cycles[1];
+			CYC_INSTRUCTION  = m68ki_cycles[1];
 			CYC_EXCEPTION    = m68ki_exception_cycle_table[1];
 			CYC_BCC_NOTAKE_B = -4;
 			CYC_BCC_NOTAKE_W = 0;
@@ -751,7 +759,7 @@ void m68k_set_cpu_type(struct m68k_module *module, unsigned int cpu_type)
 			CPU_TYPE         = CPU_TYPE_EC020;
 			CPU_ADDRESS_MASK = 0x00ffffff;
 			CPU_SR_MASK      = 0xf71f; /* T1 T0 S  M  -- I2 I1 I0 -- -- -- X  N  Z  V  C  */
-			CYC_INSTRUCTION  = module->m68ki_cycles[2];
+			CYC_INSTRUCTION  = m68ki_cycles[2];
 			CYC_EXCEPTION    = m68ki_exception_cycle_table[2];
 			CYC_BCC_NOTAKE_B = -2;
 			CYC_BCC_NOTAKE_W = 0;
@@ -768,7 +776,7 @@ void m68k_set_cpu_type(struct m68k_module *module, unsigned int cpu_type)
 			CPU_TYPE         = CPU_TYPE_020;
 			CPU_ADDRESS_MASK = 0xffffffff;
 			CPU_SR_MASK      = 0xf71f; /* T1 T0 S  M  -- I2 I1 I0 -- -- -- X  N  Z  V  C  */
-			CYC_INSTRUCTION  = module->m68ki_cycles[2];
+			CYC_INSTRUCTION  = m68ki_cycles[2];
 			CYC_EXCEPTION    = m68ki_exception_cycle_table[2];
 			CYC_BCC_NOTAKE_B = -2;
 			CYC_BCC_NOTAKE_W = 0;
@@ -785,7 +793,7 @@ void m68k_set_cpu_type(struct m68k_module *module, unsigned int cpu_type)
 			CPU_TYPE         = CPU_TYPE_030;
 			CPU_ADDRESS_MASK = 0xffffffff;
 			CPU_SR_MASK      = 0xf71f; /* T1 T0 S  M  -- I2 I1 I0 -- -- -- X  N  Z  V  C  */
-			CYC_INSTRUCTION  = module->m68ki_cycles[3];
+			CYC_INSTRUCTION  = m68ki_cycles[3];
 			CYC_EXCEPTION    = m68ki_exception_cycle_table[3];
 			CYC_BCC_NOTAKE_B = -2;
 			CYC_BCC_NOTAKE_W = 0;
@@ -802,7 +810,7 @@ void m68k_set_cpu_type(struct m68k_module *module, unsigned int cpu_type)
 			CPU_TYPE         = CPU_TYPE_EC030;
 			CPU_ADDRESS_MASK = 0xffffffff;
 			CPU_SR_MASK          = 0xf71f; /* T1 T0 S  M  -- I2 I1 I0 -- -- -- X  N  Z  V  C  */
-			CYC_INSTRUCTION  = module->m68ki_cycles[3];
+			CYC_INSTRUCTION  = m68ki_cycles[3];
 			CYC_EXCEPTION    = m68ki_exception_cycle_table[3];
 			CYC_BCC_NOTAKE_B = -2;
 			CYC_BCC_NOTAKE_W = 0;
@@ -819,7 +827,7 @@ void m68k_set_cpu_type(struct m68k_module *module, unsigned int cpu_type)
 			CPU_TYPE         = CPU_TYPE_040;
 			CPU_ADDRESS_MASK = 0xffffffff;
 			CPU_SR_MASK      = 0xf71f; /* T1 T0 S  M  -- I2 I1 I0 -- -- -- X  N  Z  V  C  */
-			CYC_INSTRUCTION  = module->m68ki_cycles[4];
+			CYC_INSTRUCTION  = m68ki_cycles[4];
 			CYC_EXCEPTION    = m68ki_exception_cycle_table[4];
 			CYC_BCC_NOTAKE_B = -2;
 			CYC_BCC_NOTAKE_W = 0;
@@ -836,7 +844,7 @@ void m68k_set_cpu_type(struct m68k_module *module, unsigned int cpu_type)
 			CPU_TYPE         = CPU_TYPE_EC040;
 			CPU_ADDRESS_MASK = 0xffffffff;
 			CPU_SR_MASK      = 0xf71f; /* T1 T0 S  M  -- I2 I1 I0 -- -- -- X  N  Z  V  C  */
-			CYC_INSTRUCTION  = module->m68ki_cycles[4];
+			CYC_INSTRUCTION  = m68ki_cycles[4];
 			CYC_EXCEPTION    = m68ki_exception_cycle_table[4];
 			CYC_BCC_NOTAKE_B = -2;
 			CYC_BCC_NOTAKE_W = 0;
@@ -852,7 +860,7 @@ void m68k_set_cpu_type(struct m68k_module *module, unsigned int cpu_type)
 		case M68K_CPU_TYPE_68LC040:
 			CPU_TYPE         = CPU_TYPE_LC040;
 			module->m68ki_cpu.sr_mask          = 0xf71f; /* T1 T0 S  M  -- I2 I1 I0 -- -- -- X  N  Z  V  C  */
-			module->m68ki_cpu.cyc_instruction  = module->m68ki_cycles[4];
+			module->m68ki_cpu.cyc_instruction  = m68ki_cycles[4];
 			module->m68ki_cpu.cyc_exception    = m68ki_exception_cycle_table[4];
 			module->m68ki_cpu.cyc_bcc_notake_b = -2;
 			module->m68ki_cpu.cyc_bcc_notake_w = 0;
@@ -865,6 +873,7 @@ void m68k_set_cpu_type(struct m68k_module *module, unsigned int cpu_type)
 			module->m68ki_cpu.cyc_reset        = 518;
 			HAS_PMMU	       = 1;
 			return;
+#endif /* !M68K_EMULATE_000_ONLY */
 	}
 }
 
@@ -873,6 +882,76 @@ void m68k_set_callback_arg(struct m68k_module *module, void *arg)
 	module->callback.arg = arg;
 }
 
+#if M68K_INSTRUCTION_CACHE
+
+static inline struct m68ki_instruction *m68ki_instruction_cache_entry(struct m68k_module *module, uint pc)
+{
+	return &module->m68ki_instruction_cache.entry[(pc >> 1) & (M68K_INSTRUCTION_CACHE_SIZE - 1)];
+}
+
+void m68k_instruction_cache_invalidate(struct m68k_module *module, unsigned int address)
+{
+	const uint pc = address & ~1;
+	struct m68ki_instruction *insn = m68ki_instruction_cache_entry(module, pc);
+	struct m68ki_instruction *prev = m68ki_instruction_cache_entry(module, pc - 2);
+
+	/* The word is either an opcode or the first extension word */
+	if (insn->tag == pc + 1)
+		insn->tag = 0;
+	if (prev->tag == pc - 1)
+		prev->tag = 0;
+
+	if (pc == CPU_PREF_ADDR)
+		module->m68ki_instruction_cache.prefetch_modified = 1;
+}
+
+void m68k_instruction_cache_flush(struct m68k_module *module)
+{
+	module->m68ki_instruction_cache = (struct m68ki_instruction_cache) { };
+}
+
+/* Read an instruction like m68ki_read_imm_16() does, but from the cache if
+ * possible, and return its handler. The cache is filled from memory, except
+ * when the opcode came from a prefetch that is no longer in memory.
+ */
+static inline void (*m68ki_read_instruction(struct m68k_module *module))(struct m68k_module *module)
+{
+	struct m68ki_instruction *insn = m68ki_instruction_cache_entry(module, REG_PC);
+
+	if (insn->tag == REG_PC + 1)
+	{
+		if (REG_PC != CPU_PREF_ADDR)
+			M68K_INSTRUCTION_CACHE_READ(module, ADDRESS_68K(REG_PC));
+		else if (MASK_OUT_ABOVE_16(CPU_PREF_DATA) != insn->ir)
+			goto miss;
+
+		REG_IR = insn->ir;
+		REG_PC += 2;
+		CPU_PREF_ADDR = REG_PC;
+		CPU_PREF_DATA = insn->ext;
+		M68K_INSTRUCTION_CACHE_READ(module, ADDRESS_68K(CPU_PREF_ADDR));
+
+		return insn->handler;
+	}
+
+miss:
+	REG_IR = m68ki_read_imm_16(module);
+
+	if (!module->m68ki_instruction_cache.prefetch_modified &&
+	    M68K_INSTRUCTION_CACHEABLE(module, REG_PPC))
+	{
+		insn->handler = m68ki_instruction_jump_table[REG_IR];
+		insn->tag = REG_PPC + 1;
+		insn->ir = REG_IR;
+		insn->ext = MASK_OUT_ABOVE_16(CPU_PREF_DATA);
+	}
+	module->m68ki_instruction_cache.prefetch_modified = 0;
+
+	return m68ki_instruction_jump_table[REG_IR];
+}
+
+#endif /* M68K_INSTRUCTION_CACHE */
+
 /* Execute some instructions until we use up num_cycles clock cycles */
 /* ASG: removed per-instruction interrupt checks */
 int m68k_execute(struct m68k_module *module, int num_cycles)
@@ -923,8 +1002,12 @@ int m68k_execute(struct m68k_module *module, int num_cycles)
 			}
 
 			/* Read an instruction and call its handler */
+#if M68K_INSTRUCTION_CACHE
+			m68ki_read_instruction(module)(module);
+#else
 			REG_IR = m68ki_read_imm_16(module);
-			module->m68ki_instruction_jump_table[REG_IR](module);
+			m68ki_instruction_jump_table[REG_IR](module);
+#endif /* M68K_INSTRUCTION_CACHE */
 			USE_CYCLES(CYC_INSTRUCTION[REG_IR]);
 
 			/* Trace m68k_exception, if necessary */
@@ -1013,8 +1096,6 @@ void m68k_init(struct m68k_module *module)
 {
 	*module = (struct m68k_module) { };
 
-	m68ki_build_opcode_table(module);
-
 	m68k_set_int_ack_callback(module, NULL);
 	m68k_set_bkpt_ack_callback(module, NULL);
 	m68k_set_reset_instr_callback(module, NULL);
@@ -12,10 +12,11 @@
  * It requires an input file to function (default m68k_in.c), but you can
  * specify your own like so:
  *
- * m68kmake <output path> <input file>
+ * m68kmake [--cpu=68000] <output path> <input file>
  *
  * where output path is the path where the output files should be placed, and
- * input file is the file to use for input.
+ * input file is the file to use for input. With --cpu=68000 only the cycle
+ * table of the 68000 is generated, for a core specialized for the 68000.
  *
  * If you modify the input file greatly from its released form, you may have
  * to tweak the configuration section a bit since I'm using static allocation
@@ -206,8 +207,8 @@ void get_base_name(char* base_name, opcode_struct* op);
 void write_function_name(FILE* filep, char* base_name);
 void add_opcode_output_table_entry(opcode_struct* op, char* name);
 static int DECL_SPEC compare_nof_true_bits(const void* aptr, const void* bptr);
+void build_opcode_jump_table(void);
 void print_opcode_output_table(FILE* filep);
-void write_table_entry(FILE* filep, opcode_struct* op);
 void set_opcode_struct(opcode_struct* src, opcode_struct* dst, int ea_mode);
 void generate_opcode_handler(FILE* filep, body_struct* body, replace_struct* replace, opcode_struct* opinfo, int ea_mode);
 void generate_opcode_ea_variants(FILE* filep, body_struct* body, replace_struct* replace, opcode_struct* op);
@@ -240,6 +241,13 @@ opcode_struct g_opcode_input_table[MAX_OPCODE_INPUT_TABLE_LENGTH];
 opcode_struct g_opcode_output_table[MAX_OPCODE_OUTPUT_TABLE_LENGTH];
 int g_opcode_output_table_length = 0;
 
+/* Opcode handler jump table, as indices into the output table, and cycles */
+int g_opcode_jump_table[0x10000];
+unsigned char g_opcode_cycle_table[NUM_CPUS][0x10000];
+
+/* Number of CPU types to generate cycle tables for, starting with the 68000 */
+int g_cpu_type_count = NUM_CPUS;
+
 const ea_info_struct g_ea_info_table[13] =
 {/* fname    ea        mask  match */
 	{"",     "",       0x00, 0x00}, /* EA_MODE_NONE */
@@ -786,31 +794,121 @@ static int DECL_SPEC compare_nof_true_bits(const void* aptr, const void* bptr)
 	return a->op_match - b->op_match;
 }
 
-void print_opcode_output_table(FILE* filep)
+/* Set an entry in the opcode handler jump table */
+static void set_jump_table_entry(int instr, const opcode_struct* ostruct)
 {
-	int i;
-	qsort((void *)g_opcode_output_table, g_opcode_output_table_length, sizeof(g_opcode_output_table[0]), compare_nof_true_bits);
+	int k;
 
-	for(i=0;i<g_opcode_output_table_length;i++)
-		write_table_entry(filep, g_opcode_output_table+i);
+	g_opcode_jump_table[instr] = ostruct ? ostruct - g_opcode_output_table : -1;
+	for(k=0;k<NUM_CPUS;k++)
+		g_opcode_cycle_table[k][instr] = ostruct ? ostruct->cycles[k] : 0;
 }
 
-/* Write an entry in the opcode handler table */
-void write_table_entry(FILE* filep, opcode_struct* op)
+/* Build the opcode handler jump table from the sorted output table */
+void build_opcode_jump_table(void)
 {
+	const opcode_struct *end = &g_opcode_output_table[g_opcode_output_table_length];
+	const opcode_struct *ostruct;
+	int cycle_cost;
+	int instr;
 	int i;
+	int j;
 
-	fprintf(filep, "\t{%-28s, 0x%04x, 0x%04x, {",
-		op->name, op->op_mask, op->op_match);
+	for(i = 0; i < 0x10000; i++)
+		set_jump_table_entry(i, NULL);	/* default to illegal */
 
-	for(i=0;i<NUM_CPUS;i++)
+	ostruct = g_opcode_output_table;
+	while(ostruct < end && ostruct->op_mask != 0xff00)
+	{
+		for(i = 0;i < 0x10000;i++)
+			if((i & ostruct->op_mask) == ostruct->op_match)
+				set_jump_table_entry(i, ostruct);
+		ostruct++;
+	}
+	while(ostruct < end && ostruct->op_mask == 0xff00)
+	{
+		for(i = 0;i <= 0xff;i++)
+			set_jump_table_entry(ostruct->op_match | i, ostruct);
+		ostruct++;
+	}
+	while(ostruct < end && ostruct->op_mask == 0xf1f8)
+	{
+		for(i = 0;i < 8;i++)
+		{
+			for(j = 0;j < 8;j++)
+			{
+				instr = ostruct->op_match | (i << 9) | j;
+				set_jump_table_entry(instr, ostruct);
+				// For all shift operations with known shift distance (encoded in instruction word)
+				if((instr & 0xf000) == 0xe000 && (!(instr & 0x20)))
+				{
+					// On the 68000 and 68010 shift distance affect execution time.
+					// Add the cycle cost of shifting; 2 times the shift distance
+					cycle_cost = ((((i-1)&7)+1)<<1);
+					g_opcode_cycle_table[CPU_TYPE_000][instr] += cycle_cost;
+					g_opcode_cycle_table[CPU_TYPE_010][instr] += cycle_cost;
+					// On the 68020 shift distance does not affect execution time
+				}
+			}
+		}
+		ostruct++;
+	}
+	while(ostruct < end && ostruct->op_mask == 0xfff0)
+	{
+		for(i = 0;i <= 0x0f;i++)
+			set_jump_table_entry(ostruct->op_match | i, ostruct);
+		ostruct++;
+	}
+	while(ostruct < end && ostruct->op_mask == 0xf1ff)
 	{
-		fprintf(filep, "%3d", op->cycles[i]);
-		if(i < NUM_CPUS-1)
-			fprintf(filep, ", ");
+		for(i = 0;i <= 0x07;i++)
+			set_jump_table_entry(ostruct->op_match | (i << 9), ostruct);
+		ostruct++;
 	}
+	while(ostruct < end && ostruct->op_mask == 0xfff8)
+	{
+		for(i = 0;i <= 0x07;i++)
+			set_jump_table_entry(ostruct->op_match | i, ostruct);
+		ostruct++;
+	}
+	while(ostruct < end && ostruct->op_mask == 0xffff)
+	{
+		set_jump_table_entry(ostruct->op_match, ostruct);
+		ostruct++;
+	}
+}
+
+/*
+ * Print the opcode handler jump table and the cycle tables as constant
+ * data, such that they need not be built when the processor is initialised.
+ */
+void print_opcode_output_table(FILE* filep)
+{
+	int i;
+	int k;
+
+	qsort((void *)g_opcode_output_table, g_opcode_output_table_length, sizeof(g_opcode_output_table[0]), compare_nof_true_bits);
+
+	build_opcode_jump_table();
+
+	fprintf(filep, "/* Opcode handler jump table */\n");
+	fprintf(filep, "void (*const m68ki_instruction_jump_table[0x10000])(struct m68k_module *module) =\n{\n");
+	for(i = 0;i < 0x10000;i++)
+		fprintf(filep, "\t/* %04x */ %s,\n", i, g_opcode_jump_table[i] < 0 ?
+			"m68k_op_illegal" : g_opcode_output_table[g_opcode_jump_table[i]].name);
+	fprintf(filep, "};\n\n");
 
-	fprintf(filep, "}},\n");
+	fprintf(filep, "/* Cycles used by CPU type */\n");
+	fprintf(filep, "const unsigned char m68ki_cycles[M68KOPS_CPU_TYPES][0x10000] =\n{\n");
+	for(k = 0;k < g_cpu_type_count;k++)
+	{
+		fprintf(filep, "\t{\n");
+		for(i = 0;i < 0x10000;i++)
+			fprintf(filep, "%s%3d,%s", i % 16 ? " " : "\t\t",
+				g_opcode_cycle_table[k][i], i % 16 == 15 ? "\n" : "");
+		fprintf(filep, "\t},\n");
+	}
+	fprintf(filep, "};\n");
 }
 
 /* Fill out an opcode struct with a specific addressing mode of the source opcode struct */
@@ -1207,6 +1305,16 @@ int main(int argc, char **argv)
 	int table_body_read = 0;
 	int ophandler_body_read = 0;
 
+	/* Check if the CPU is given */
+	if(argc > 1 && strncmp(argv[1], "--cpu=", 6) == 0)
+	{
+		if(strcmp(argv[1], "--cpu=68000") != 0)
+			error_exit("Unsupported CPU: %s", &argv[1][6]);
+		g_cpu_type_count = 1;
+		argc--;
+		argv++;
+	}
+
 	/* Check if output path and source for the input file are given */
     if(argc > 1)
 	{
@@ -1348,6 +1456,8 @@ int main(int argc, char **argv)
 			print_opcode_output_table(g_table_file);
 			fprintf(g_table_file, "%s\n\n", table_footer_insert);
 
+			fprintf(g_prototype_file, "/* Number of CPU types with cycle tables */\n");
+			fprintf(g_prototype_file, "#define M68KOPS_CPU_TYPES %d\n\n", g_cpu_type_count);
 			fprintf(g_prototype_file, "%s\n\n", prototype_footer_insert);
 
 			break;
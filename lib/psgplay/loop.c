@@ -0,0 +1,322 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (C) 2026 Fredrik Noring
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "internal/compare.h"
+#include "internal/psgplay.h"
+
+#include "atari/machine.h"
+
+#include "psgplay/digital.h"
+#include "psgplay/loop.h"
+#include "psgplay/psgplay.h"
+#include "psgplay/ym.h"
+
+#define LOOP_PLAY_ADDRESS (MACHINE_PROGRAM + 8)	/* SNDH play subroutine */
+#define LOOP_READ_SAMPLES 65536
+#define RAM_PAGE_SIZE (1 << MACHINE_RAM_PAGE_SHIFT)
+
+/**
+ * struct loop_tick - machine state fingerprint at an SNDH play call
+ * @fingerprint: hash of PSG registers, DMA sound registers and RAM
+ * @cycle: machine cycle of the call
+ */
+struct loop_tick {
+	uint64_t fingerprint;
+	uint64_t cycle;
+};
+
+/**
+ * struct loop_state - loop detection state
+ * @pp: PSG play object to analyse
+ * @psg: YM2149 PSG registers, shadowed by register writes
+ * @page: hash of each RAM page, or zero if never changed
+ * @ram: sum of @page hash changes, updated for pages changed since
+ * 	previous tick, such that it only depends on the RAM contents
+ * @changed: bitmap of RAM pages changed since previous tick
+ * @copy: copy of RAM pages at previous tick
+ * @tick: fingerprints, in the order of SNDH play calls
+ * @tick.count: number of fingerprints
+ * @tick.capacity: number of allocated fingerprints
+ * @tick.entry: fingerprints
+ * @table: open addressing hash table of @tick indices by fingerprint
+ * @table.capacity: number of slots, a power of two or zero
+ * @table.slot: @tick index plus one, or zero for an empty slot
+ * @loop: loop result
+ * @found: %true if @loop has been detected
+ * @err: errno on failure, otherwise zero
+ */
+struct loop_state {
+	struct psgplay *pp;
+
+	uint8_t psg[16];
+
+	uint64_t page[MACHINE_RAM_PAGE_COUNT];
+	uint64_t ram;
+	uint32_t changed[MACHINE_RAM_PAGE_COUNT / 32];
+	uint8_t copy[MACHINE_RAM_SIZE];
+
+	struct {
+		size_t count;
+		size_t capacity;
+		struct loop_tick *entry;
+	} tick;
+
+	struct {
+		size_t capacity;
+		size_t *slot;
+	} table;
+
+	struct psgplay_loop loop;
+	bool found;
+	int err;
+};
+
+static uint64_t fnv1a(uint64_t h, const void *data, size_t size)
+{
+	const uint8_t *b = data;
+
+	for (size_t i = 0; i < size; i++)
+		h = (h ^ b[i]) * 0x100000001b3;
+
+	return h;
+}
+
+static uint64_t hash(const void *data, size_t size)
+{
+	return fnv1a(0xcbf29ce484222325, data, size);
+}
+
+static bool ram_page_bit(const uint32_t *bitmap, uint32_t page)
+{
+	return bitmap[page / 32] & (1u << (page % 32));
+}
+
+/*
+ * The machine dirty bits are pages written since reset, which are also
+ * needed by ram_reset() and psgplay_snapshot() and therefore must not be
+ * cleared. Pages changed since the previous tick are instead found by
+ * comparing the dirty pages with their copies, which is much faster than
+ * hashing them again.
+ */
+static void loop_ram_changed(struct loop_state *ls)
+{
+	const struct machine *machine = &ls->pp->machine;
+
+	for (uint32_t page = 0; page < MACHINE_RAM_PAGE_COUNT; page++) {
+		if (!ram_page_bit(machine->ram.dirty, page))
+			continue;
+
+		const uint8_t *p = &machine->ram.u8[page * RAM_PAGE_SIZE];
+		uint8_t *copy = &ls->copy[page * RAM_PAGE_SIZE];
+
+		if (!memcmp(copy, p, RAM_PAGE_SIZE))
+			continue;
+
+		memcpy(copy, p, RAM_PAGE_SIZE);
+		ls->changed[page / 32] |= 1u << (page % 32);
+	}
+}
+
+static uint64_t loop_page_hash(uint32_t page, const uint8_t *data)
+{
+	return fnv1a(hash(&page, sizeof(page)), data, RAM_PAGE_SIZE);
+}
+
+static void loop_ram_update(struct loop_state *ls)
+{
+	static const uint8_t zero[RAM_PAGE_SIZE];
+
+	loop_ram_changed(ls);
+
+	for (uint32_t page = 0; page < MACHINE_RAM_PAGE_COUNT; page++) {
+		if (!ram_page_bit(ls->changed, page))
+			continue;
+
+		const uint64_t h = loop_page_hash(page,
+			&ls->copy[page * RAM_PAGE_SIZE]);
+
+		/* RAM is initially zero, as are the copies. */
+		if (!ls->page[page])
+			ls->page[page] = loop_page_hash(page, zero);
+
+		ls->ram += h - ls->page[page];
+		ls->page[page] = h;
+	}
+
+	memset(ls->changed, 0, sizeof(ls->changed));
+}
+
+static uint64_t loop_fingerprint(struct loop_state *ls)
+{
+	const struct cf300588_sound_module *cf300588 =
+		&ls->pp->machine.sound.cf300588;
+
+	loop_ram_update(ls);
+
+	uint64_t h = hash(ls->psg, sizeof(ls->psg));
+
+	h = fnv1a(h, &cf300588->state.regs, sizeof(cf300588->state.regs));
+
+	return fnv1a(h, &ls->ram, sizeof(ls->ram));
+}
+
+static size_t *loop_slot(struct loop_state *ls, uint64_t fingerprint)
+{
+	const size_t mask = ls->table.capacity - 1;
+
+	for (size_t i = fingerprint & mask; ; i = (i + 1) & mask) {
+		size_t *slot = &ls->table.slot[i];
+
+		if (!*slot ||
+		    ls->tick.entry[*slot - 1].fingerprint == fingerprint)
+			return slot;
+	}
+}
+
+static int loop_table_grow(struct loop_state *ls)
+{
+	const size_t capacity = ls->table.capacity ?
+		2 * ls->table.capacity : 1024;
+	size_t *slot = calloc(capacity, sizeof(*slot));
+
+	if (!slot)
+		return errno;
+
+	free(ls->table.slot);
+	ls->table.slot = slot;
+	ls->table.capacity = capacity;
+
+	for (size_t i = 0; i < ls->tick.count; i++)
+		*loop_slot(ls, ls->tick.entry[i].fingerprint) = i + 1;
+
+	return 0;
+}
+
+static int loop_tick_append(struct loop_state *ls, struct loop_tick tick)
+{
+	if (ls->tick.capacity <= ls->tick.count) {
+		const size_t capacity = ls->tick.capacity +
+			max_t(size_t, ls->tick.capacity, 1024);
+
+		void *entry = realloc(ls->tick.entry,
+			capacity * sizeof(*ls->tick.entry));
+		if (!entry)
+			return errno;
+
+		ls->tick.entry = entry;
+		ls->tick.capacity = capacity;
+	}
+
+	if (ls->table.capacity <= 2 * (ls->tick.count + 1)) {
+		const int err = loop_table_grow(ls);
+
+		if (err)
+			return err;
+	}
+
+	ls->tick.entry[ls->tick.count] = tick;
+	*loop_slot(ls, tick.fingerprint) = ++ls->tick.count;
+
+	return 0;
+}
+
+/*
+ * Loop times are measured from machine cycle zero, which is the start of
+ * the tune, as for psgplay_stop_at_time(), rather than from the first call
+ * of the play subroutine, which is up to one tick later.
+ */
+static float loop_time(uint64_t cycle)
+{
+	return cycle / (double)CPU_FREQUENCY;
+}
+
+static void loop_tick(uint32_t pc, void *arg)
+{
+	struct loop_state *ls = arg;
+
+	if (pc != LOOP_PLAY_ADDRESS || ls->found || ls->err)
+		return;
+
+	const struct loop_tick tick = {
+		.fingerprint = loop_fingerprint(ls),
+		.cycle = machine_cycle(&ls->pp->machine),
+	};
+
+	const size_t *slot = ls->table.capacity ?
+		loop_slot(ls, tick.fingerprint) : NULL;
+
+	if (slot && *slot) {
+		const size_t index = *slot - 1;
+		const struct loop_tick *first = &ls->tick.entry[index];
+
+		ls->loop = (struct psgplay_loop) {
+			.start = loop_time(first->cycle),
+			.length = (tick.cycle - first->cycle) /
+				(double)CPU_FREQUENCY,
+			.end = index + 1 == ls->tick.count,
+		};
+		ls->found = true;
+		return;
+	}
+
+	ls->err = loop_tick_append(ls, tick);
+}
+
+static void loop_psg_register(struct psgplay *pp,
+	const struct psgplay_psg_register *reg, void *arg)
+{
+	struct loop_state *ls = arg;
+
+	ls->psg[reg->reg % 16] = reg->value;
+}
+
+int psgplay_loop(struct psgplay_loop *loop,
+	const void *data, size_t size, int track, float limit)
+{
+	struct loop_state *ls = calloc(1, sizeof(*ls));
+	int ret = -1;
+
+	if (!ls)
+		return -1;
+
+	ls->pp = psgplay_init(data, size, track, 0);
+	if (!ls->pp)
+		goto out;
+
+	psgplay_psg_register_callback(ls->pp, loop_psg_register, ls);
+	psgplay_instruction_callback(ls->pp, loop_tick, ls);
+	psgplay_stop_at_time(ls->pp, limit);
+
+	for (;;) {
+		const ssize_t r = psgplay_read_digital(ls->pp,
+			NULL, LOOP_READ_SAMPLES);
+
+		if (ls->err) {
+			errno = ls->err;
+			break;
+		} else if (r < 0) {
+			break;
+		} else if (ls->found) {
+			*loop = ls->loop;
+			ret = 1;
+			break;
+		} else if (!r) {
+			ret = 0;
+			break;
+		}
+	}
+
+out:
+	psgplay_free(ls->pp);
+	free(ls->table.slot);
+	free(ls->tick.entry);
+	free(ls);
+
+	return ret;
+}
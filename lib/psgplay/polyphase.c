@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (C) 2026 Fredrik Noring
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include "internal/macro.h"
+#include "internal/polyphase.h"
+
+#include "atari/psg.h"
+
+#include "psgplay/stereo.h"
+
+#include "internal/polyphase-table.h"
+
+/**
+ * struct psgplay_stereo_polyphase - polyphase resampler state
+ * @table: filter coefficients for the output sample frequency
+ * @step: output sample frequency times 8, being the increment of @phase
+ * 	for every 250.332 kHz input sample
+ * @phase: negative until the next output sample is due
+ * @position: index of the most recent sample in the history
+ * @history: doubled sample history, such that the most recent
+ * 	%POLYPHASE_TAPS samples are contiguous from @position
+ */
+struct psgplay_stereo_polyphase {
+	const struct polyphase_table *table;
+	int64_t step;
+	int64_t phase;
+	size_t position;
+	struct {
+		int16_t left[2 * POLYPHASE_TAPS];
+		int16_t right[2 * POLYPHASE_TAPS];
+	} history;
+};
+
+struct psgplay_stereo_polyphase *psgplay_stereo_polyphase_init(
+	int frequency)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(polyphase_table); i++) {
+		if (polyphase_table[i].frequency != frequency)
+			continue;
+
+		struct psgplay_stereo_polyphase *polyphase =
+			calloc(1, sizeof(*polyphase));
+
+		if (!polyphase)
+			return NULL;
+
+		polyphase->table = &polyphase_table[i];
+		polyphase->step = 8 * (int64_t)frequency;
+		polyphase->phase = -PSG_FREQUENCY;
+
+		return polyphase;
+	}
+
+	errno = EINVAL;
+	return NULL;
+}
+
+static int16_t polyphase_sample(const int16_t *sample,
+	const int16_t *coefficient)
+{
+	int32_t a = 0;
+
+	/* Simple enough for the compiler to vectorise. */
+	for (size_t m = 0; m < POLYPHASE_TAPS; m++)
+		a += sample[m] * coefficient[m];
+
+	a = (a + (1 << (POLYPHASE_SHIFT - 1))) >> POLYPHASE_SHIFT;
+
+	return a < INT16_MIN ? INT16_MIN : a > INT16_MAX ? INT16_MAX : a;
+}
+
+size_t psgplay_stereo_downsample_polyphase(struct psgplay_stereo *resample,
+	const struct psgplay_stereo *stereo, size_t count, void *arg)
+{
+	struct psgplay_stereo_polyphase *polyphase = arg;
+	size_t r = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		const size_t p = polyphase->position = polyphase->position ?
+			polyphase->position - 1 : POLYPHASE_TAPS - 1;
+
+		polyphase->history.left[p] =
+		polyphase->history.left[p + POLYPHASE_TAPS] = stereo[i].left;
+		polyphase->history.right[p] =
+		polyphase->history.right[p + POLYPHASE_TAPS] = stereo[i].right;
+
+		/*
+		 * The phase is the distance from the output sample to the
+		 * most recent input sample, as a fraction of input samples.
+		 */
+		for (; polyphase->phase >= 0;
+		       polyphase->phase -= PSG_FREQUENCY) {
+			const int16_t *c = polyphase->table->coefficient[
+				(polyphase->phase * POLYPHASE_PHASES) /
+					polyphase->step];
+
+			resample[r++] = (struct psgplay_stereo) {
+				.left  = polyphase_sample(
+					&polyphase->history.left[p], c),
+				.right = polyphase_sample(
+					&polyphase->history.right[p], c),
+			};
+		}
+
+		polyphase->phase += polyphase->step;
+	}
+
+	return r;
+}
+
+struct psgplay_stereo_polyphase *psgplay_stereo_polyphase_snapshot(
+	const struct psgplay_stereo_polyphase *polyphase)
+{
+	struct psgplay_stereo_polyphase *snapshot =
+		malloc(sizeof(*snapshot));
+
+	if (snapshot)
+		*snapshot = *polyphase;
+
+	return snapshot;
+}
+
+int psgplay_stereo_polyphase_restore(
+	struct psgplay_stereo_polyphase *polyphase,
+	const struct psgplay_stereo_polyphase *snapshot)
+{
+	if (polyphase->table != snapshot->table) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	*polyphase = *snapshot;
+
+	return 0;
+}
+
+void psgplay_stereo_polyphase_free(struct psgplay_stereo_polyphase *polyphase)
+{
+	free(polyphase);
+}
@@ -0,0 +1,156 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (C) 2026 Fredrik Noring
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "internal/polyphase.h"
+
+#include "atari/psg.h"
+
+/*
+ * Kaiser windowed-sinc lowpass filter, with the cutoff frequency at 45 %
+ * of the output sample frequency. With 128 taps and beta 7 the stopband
+ * attenuation is about 70 dB, such that aliasing folded into the audible
+ * band is well below the 16-bit quantisation noise of loud music.
+ */
+
+#define CUTOFF 0.45
+#define BETA 7.0
+
+static double bessel_i0(const double x)
+{
+	double sum = 1.0, term = 1.0;
+
+	for (int k = 1; term > 1e-12 * sum; k++) {
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+	}
+
+	return sum;
+}
+
+static double kaiser(const double t)
+{
+	const double r = t / (POLYPHASE_TAPS / 2);
+
+	return r <= -1.0 || r >= 1.0 ? 0.0 :
+		bessel_i0(BETA * sqrt(1.0 - r * r)) / bessel_i0(BETA);
+}
+
+static double sinc(const double x)
+{
+	return x == 0.0 ? 1.0 : sin(M_PI * x) / (M_PI * x);
+}
+
+static bool generate_phase(int16_t coefficient[POLYPHASE_TAPS],
+	const int phase, const double fc)
+{
+	const double delta = (double)phase / POLYPHASE_PHASES;
+	double h[POLYPHASE_TAPS];
+	double sum = 0.0;
+	int total = 0;
+	int centre = 0;
+
+	for (int m = 0; m < POLYPHASE_TAPS; m++) {
+		const double t = m - delta - (POLYPHASE_TAPS / 2 - 1);
+
+		h[m] = sinc(2.0 * fc * t) * kaiser(t);
+		sum += h[m];
+	}
+
+	for (int m = 0; m < POLYPHASE_TAPS; m++) {
+		coefficient[m] = lrint((1 << POLYPHASE_SHIFT) * h[m] / sum);
+		total += coefficient[m];
+
+		if (coefficient[m] > coefficient[centre])
+			centre = m;
+	}
+
+	/* Each phase sums to exactly 1 to have unity gain at DC. */
+	coefficient[centre] += (1 << POLYPHASE_SHIFT) - total;
+
+	/* Accumulate a phase of full scale samples without overflow. */
+	int64_t bound = 0;
+	for (int m = 0; m < POLYPHASE_TAPS; m++)
+		bound += 32768 * abs(coefficient[m]);
+
+	return bound <= INT32_MAX;
+}
+
+static bool generate_table(struct polyphase_table *table, const int frequency)
+{
+	const double fc = CUTOFF * frequency / (PSG_FREQUENCY / 8.0);
+
+	table->frequency = frequency;
+
+	for (int p = 0; p < POLYPHASE_PHASES; p++)
+		if (!generate_phase(table->coefficient[p], p, fc))
+			return false;
+
+	return true;
+}
+
+static bool write_table(FILE *f, const struct polyphase_table *table)
+{
+	fprintf(f, "{\n\t.frequency = %d,\n\t.coefficient = {\n",
+		table->frequency);
+	for (int p = 0; p < POLYPHASE_PHASES; p++) {
+		fprintf(f, "\t{");
+		for (int m = 0; m < POLYPHASE_TAPS; m++)
+			fprintf(f, "%s%6d,", m % 8 ? " " : "\n\t\t",
+				table->coefficient[p][m]);
+		fprintf(f, "\n\t},\n");
+	}
+	fprintf(f, "} },\n");
+
+	return !ferror(f);
+}
+
+int main(int argc, char *argv[])
+{
+	static struct polyphase_table table;
+
+	if (argc < 4 || strcmp(argv[1], "-o") != 0)
+		return EXIT_FAILURE;
+
+	FILE *f = fopen(argv[2], "w");
+	if (!f) {
+		perror(argv[2]);
+		return EXIT_FAILURE;
+	}
+
+	bool valid = true;
+
+	fprintf(f, "static const struct polyphase_table polyphase_table[] = {\n");
+	for (int i = 3; i < argc && valid; i++) {
+		const int frequency = atoi(argv[i]);
+
+		if (frequency <= 0 || 8 * frequency >= PSG_FREQUENCY) {
+			errno = EINVAL;
+			valid = false;
+		} else if (!generate_table(&table, frequency)) {
+			errno = ERANGE;
+			valid = false;
+		} else
+			valid = write_table(f, &table);
+	}
+	fprintf(f, "};\n");
+
+	if (ferror(f))
+		valid = false;
+
+	if (fclose(f) == EOF || !valid) {
+		perror(argv[2]);
+		remove(argv[2]);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
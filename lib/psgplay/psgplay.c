@@ -4,16 +4,24 @@
  */
 
 #include <errno.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef HAVE_AVX2
+#include <immintrin.h>
+#endif
+
 #include "toslibc/asm/machine.h"
 
+#include "internal/build-assert.h"
 #include "internal/compare.h"
 #include "internal/psgplay.h"
+#include "internal/stats.h"
 
 #include "atari/cpu.h"
 #include "atari/dac.h"
+#include "atari/device.h"
 #include "atari/machine.h"
 #include "atari/psg.h"
 
@@ -21,12 +29,16 @@
 #include "psgplay/stereo.h"
 #include "psgplay/digital.h"
 #include "psgplay/sndh.h"
+#include "psgplay/stats.h"
+#include "psgplay/ym.h"
 
 #include "cf2149/module/cf2149.h"
 #include "cf2149/module/dac.h"
 
 #define FADE_SAMPLES 2500	/* 10 ms with 250 kHz */
 
+#define DIGITAL_TO_STEREO_BLOCK 4096	/* 16 ms with 250 kHz */
+
 #define RECORD_PLAY_DEFAULT ((10 * ATARI_STE_EXT_OSC) / 4 / 16)    /* 10 s */
 
 static int buffer_stereo_sample(struct stereo_buffer *sb,
@@ -44,6 +56,7 @@ static int buffer_stereo_sample(struct stereo_buffer *sb,
 
 			sb->sample = sample;
 			sb->capacity = capacity;
+			stats_inc(sb->reallocations);
 		}
 
 		sb->sample[sb->count++] = stereo[i];
@@ -63,6 +76,7 @@ static int digital_buffer_allocate(struct digital_buffer *db)
 
 	db->sample = sample;
 	db->capacity = capacity;
+	stats_inc(db->reallocations);
 
 	return 0;
 }
@@ -141,20 +155,77 @@ static int16_t sample_lowpass(int16_t sample, struct fir8 *lowpass)
 	return x / ARRAY_SIZE(lowpass->xn);
 }
 
-struct mixer {
+static const float mixer_gain[] = {
+	1.000000000, /* g = 10^(v/20) for 0 ... -120 dB */
+	0.891250938, 0.794328235, 0.707945784, 0.630957344,
+	0.562341325, 0.501187234, 0.446683592, 0.398107171,
+	0.354813389, 0.316227766, 0.281838293, 0.251188643,
+	0.223872114, 0.199526231, 0.177827941, 0.158489319,
+	0.141253754, 0.125892541, 0.112201845, 0.100000000,
+	0.089125094, 0.079432823, 0.070794578, 0.063095734,
+	0.056234133, 0.050118723, 0.044668359, 0.039810717,
+	0.035481339, 0.031622777, 0.028183829, 0.025118864,
+	0.022387211, 0.019952623, 0.017782794, 0.015848932,
+	0.014125375, 0.012589254, 0.011220185, 0.010000000,
+	0.008912509, 0.007943282, 0.007079458, 0.006309573,
+	0.005623413, 0.005011872, 0.004466836, 0.003981072,
+	0.003548134, 0.003162278, 0.002818383, 0.002511886,
+	0.002238721, 0.001995262, 0.001778279, 0.001584893,
+	0.001412538, 0.001258925, 0.001122018, 0.001000000,
+	0.000891251, 0.000794328, 0.000707946, 0.000630957,
+	0.000562341, 0.000501187, 0.000446684, 0.000398107,
+	0.000354813, 0.000316228, 0.000281838, 0.000251189,
+	0.000223872, 0.000199526, 0.000177828, 0.000158489,
+	0.000141254, 0.000125893, 0.000112202, 0.000100000,
+	0.000089125, 0.000079433, 0.000070795, 0.000063096,
+	0.000056234, 0.000050119, 0.000044668, 0.000039811,
+	0.000035481, 0.000031623, 0.000028184, 0.000025119,
+	0.000022387, 0.000019953, 0.000017783, 0.000015849,
+	0.000014125, 0.000012589, 0.000011220, 0.000010000,
+	0.000008913, 0.000007943, 0.000007079, 0.000006310,
+	0.000005623, 0.000005012, 0.000004467, 0.000003981,
+	0.000003548, 0.000003162, 0.000002818, 0.000002512,
+	0.000002239, 0.000001995, 0.000001778, 0.000001585,
+	0.000001413, 0.000001259, 0.000001122, 0.000001000,
+};
+
+static float gain_from_volume(const int volume)
+{
+	return mixer_gain[clamp_t(int, -volume, 0, ARRAY_SIZE(mixer_gain) - 1)];
+}
+
+#define DAC_S16_BITS(S) ((S) * 0xffff - 0x8000)
+
+static const int32_t psg_dac_level[32] = CF2149_DAC_5_BIT_LEVEL(DAC_S16_BITS);
+
+static int16_t psg_dac(const union psgplay_digital_level level)
+{
+	return psg_dac_level[level.u5];
+}
+
+/**
+ * struct mix - digital to stereo mix
+ * @lvl: empiric DAC levels indexed by PSG channels C, B and A, or %NULL
+ * 	to mix PSG channels by weight
+ * @psg: %true to mix PSG channels, otherwise PSG is muted
+ * @enable: %true to apply the mixer volume
+ * @stereo: %true if the left and right weights differ
+ * @weight: left and right weights of PSG channels A, B and C, where
+ * 	256 * 3 is unity
+ */
+struct mix {
+	const uint16_t *lvl;
+	bool psg;
 	bool enable;
-	struct {
-		int left;
-		int right;
-	} volume;
-	struct {
-		float left;
-		float right;
-	} gain;
+	bool stereo;
+	struct mix_weight {
+		int a;
+		int b;
+		int c;
+	} weight[2];
 };
 
-static struct mixer mixer_init(
-	const struct psgplay_digital *digital, size_t count)
+static bool mixer_enable(const struct psgplay_digital *digital, size_t count)
 {
 	int8_t enable = 0;
 
@@ -165,110 +236,349 @@ static struct mixer mixer_init(
 		       |  digital[i].mixer.tone.bass
 		       |  digital[i].mixer.tone.treble;
 
-	return (struct mixer) {
-		.enable = enable,
-		.gain = { .left = 1.0f, .right = 1.0 }
-	};
+	return enable;
 }
 
-static float gain_from_volume(const int volume)
+static struct mix mix_init(const struct psgplay_digital *digital,
+	size_t count, const uint16_t *lvl, struct mix_weight left,
+	struct mix_weight right)
 {
-	static const float gain[] = {
-		1.000000000, /* g = 10^(v/20) for 0 ... -120 dB */
-		0.891250938, 0.794328235, 0.707945784, 0.630957344,
-		0.562341325, 0.501187234, 0.446683592, 0.398107171,
-		0.354813389, 0.316227766, 0.281838293, 0.251188643,
-		0.223872114, 0.199526231, 0.177827941, 0.158489319,
-		0.141253754, 0.125892541, 0.112201845, 0.100000000,
-		0.089125094, 0.079432823, 0.070794578, 0.063095734,
-		0.056234133, 0.050118723, 0.044668359, 0.039810717,
-		0.035481339, 0.031622777, 0.028183829, 0.025118864,
-		0.022387211, 0.019952623, 0.017782794, 0.015848932,
-		0.014125375, 0.012589254, 0.011220185, 0.010000000,
-		0.008912509, 0.007943282, 0.007079458, 0.006309573,
-		0.005623413, 0.005011872, 0.004466836, 0.003981072,
-		0.003548134, 0.003162278, 0.002818383, 0.002511886,
-		0.002238721, 0.001995262, 0.001778279, 0.001584893,
-		0.001412538, 0.001258925, 0.001122018, 0.001000000,
-		0.000891251, 0.000794328, 0.000707946, 0.000630957,
-		0.000562341, 0.000501187, 0.000446684, 0.000398107,
-		0.000354813, 0.000316228, 0.000281838, 0.000251189,
-		0.000223872, 0.000199526, 0.000177828, 0.000158489,
-		0.000141254, 0.000125893, 0.000112202, 0.000100000,
-		0.000089125, 0.000079433, 0.000070795, 0.000063096,
-		0.000056234, 0.000050119, 0.000044668, 0.000039811,
-		0.000035481, 0.000031623, 0.000028184, 0.000025119,
-		0.000022387, 0.000019953, 0.000017783, 0.000015849,
-		0.000014125, 0.000012589, 0.000011220, 0.000010000,
-		0.000008913, 0.000007943, 0.000007079, 0.000006310,
-		0.000005623, 0.000005012, 0.000004467, 0.000003981,
-		0.000003548, 0.000003162, 0.000002818, 0.000002512,
-		0.000002239, 0.000001995, 0.000001778, 0.000001585,
-		0.000001413, 0.000001259, 0.000001122, 0.000001000,
+	return (struct mix) {
+		.lvl = lvl,
+		.psg = count && digital->mixer.mix,
+		.enable = mixer_enable(digital, count),
+		.stereo = left.a != right.a ||
+			  left.b != right.b ||
+			  left.c != right.c,
+		.weight = { left, right },
 	};
+}
 
-	return gain[clamp_t(int, -volume, 0, ARRAY_SIZE(gain) - 1)];
+static size_t psg_lvl_index(const struct psgplay_digital_psg psg)
+{
+	return (psg.lvc.u5 << 10) | (psg.lvb.u5 << 5) | psg.lva.u5;
 }
 
-static inline void mixer_for_sample(struct mixer *m,
-	const struct psgplay_digital d)
+static int16_t psg_weight(const struct psgplay_digital_psg psg,
+	const struct mix_weight w)
 {
-	if (m->volume.left  == d.mixer.volume.main + d.mixer.volume.left &&
-	    m->volume.right == d.mixer.volume.main + d.mixer.volume.right)
-		return;
+	return (w.a * psg_dac(psg.lva) +
+		w.b * psg_dac(psg.lvb) +
+		w.c * psg_dac(psg.lvc)) / (256 * 3);
+}
 
-	m->volume.left  = d.mixer.volume.main + d.mixer.volume.left;
-	m->volume.right = d.mixer.volume.main + d.mixer.volume.right;
+/* PSG to DMA sound proportions, with 255 being unity. */
+#define MIX_PSG (int)(255 * 0.65f)
+#define MIX_SOUND (255 - MIX_PSG)
 
-	m->gain.left  = gain_from_volume(m->volume.left);
-	m->gain.right = gain_from_volume(m->volume.right);
+static struct psgplay_stereo mix_psg(const int16_t left, const int16_t right)
+{
+	return (struct psgplay_stereo) { .left = left, .right = right };
 }
 
-static inline struct psgplay_stereo stereo_mix(struct mixer *m,
-	const int16_t sl, const int16_t sr, const struct psgplay_digital d)
+static void mix_scalar_psg(const struct mix *mix, struct psgplay_stereo *stereo,
+	const struct psgplay_digital *digital, const size_t count)
 {
-	const float psg_mix = 0.65;
-	const int p = 255 * psg_mix;
-	const int q = 255 - p;
+	if (!mix->psg)
+		for (size_t i = 0; i < count; i++)
+			stereo[i] = mix_psg(0, 0);
+	else if (mix->lvl)
+		for (size_t i = 0; i < count; i++) {
+			const int16_t s = mix->lvl[psg_lvl_index(digital[i].psg)]
+				- 0x8000;
+
+			stereo[i] = mix_psg(s, s);
+		}
+	else if (!mix->stereo)
+		for (size_t i = 0; i < count; i++) {
+			const int16_t s = psg_weight(digital[i].psg,
+				mix->weight[0]);
 
-	if (m->enable) {
-		mixer_for_sample(m, d);
+			stereo[i] = mix_psg(s, s);
+		}
+	else
+		for (size_t i = 0; i < count; i++)
+			stereo[i] = mix_psg(
+				psg_weight(digital[i].psg, mix->weight[0]),
+				psg_weight(digital[i].psg, mix->weight[1]));
+}
 
-		return (struct psgplay_stereo) {
-			.left  = m->gain.left  * (q*d.sound.left  + p*sl) / 256,
-			.right = m->gain.right * (q*d.sound.right + p*sr) / 256
-		};
-	} else
-		return (struct psgplay_stereo) {
-			.left  = (q*d.sound.left  + p*sl) / 256,
-			.right = (q*d.sound.right + p*sr) / 256
-		};
+/*
+ * The portable kernel first writes the PSG mix to @stereo, and then mixes
+ * it with DMA sound, with the choice of mix made once for each pass rather
+ * than for each sample.
+ */
+static size_t mix_scalar(const struct mix *mix, struct psgplay_stereo *stereo,
+	const struct psgplay_digital *digital, const size_t count)
+{
+	mix_scalar_psg(mix, stereo, digital, count);
+
+	if (!mix->enable)
+		for (size_t i = 0; i < count; i++) {
+			const struct psgplay_digital *d = &digital[i];
+
+			stereo[i] = (struct psgplay_stereo) {
+				.left  = (MIX_SOUND * d->sound.left +
+					  MIX_PSG * stereo[i].left) / 256,
+				.right = (MIX_SOUND * d->sound.right +
+					  MIX_PSG * stereo[i].right) / 256,
+			};
+		}
+	else
+		for (size_t i = 0; i < count; i++) {
+			const struct psgplay_digital *d = &digital[i];
+			const float gain_left = gain_from_volume(
+				d->mixer.volume.main + d->mixer.volume.left);
+			const float gain_right = gain_from_volume(
+				d->mixer.volume.main + d->mixer.volume.right);
+
+			stereo[i] = (struct psgplay_stereo) {
+				.left  = (int16_t)(gain_left *
+					(MIX_SOUND * d->sound.left +
+					 MIX_PSG * stereo[i].left) / 256),
+				.right = (int16_t)(gain_right *
+					(MIX_SOUND * d->sound.right +
+					 MIX_PSG * stereo[i].right) / 256),
+			};
+		}
+
+	return count;
 }
 
-static int16_t psg_dac(const union psgplay_digital_level level)
+#ifdef HAVE_AVX2
+/*
+ * The AVX2 kernel mixes eight samples at a time. Empiric DAC levels and
+ * mixer gains are gathered from their tables, and linear DAC levels are
+ * permuted from registers. The result is identical to mix_scalar(), since
+ * integer division truncates in the same way and floating point operations
+ * are the same and in the same order.
+ */
+
+#define MIX_AVX2 __attribute__((__target__("avx2")))
+
+/* Channel levels are the five most significant bits, on little-endian. */
+MIX_AVX2 static __m256i mix_avx2_level(const __m256i psg, const int channel)
 {
-#define DAC_S16_BITS(S) ((S) * 0xffff - 0x8000)
-	static const int16_t dac[32] = CF2149_DAC_5_BIT_LEVEL(DAC_S16_BITS);
+	return _mm256_and_si256(_mm256_srli_epi32(psg, 8 * channel + 3),
+		_mm256_set1_epi32(0x1f));
+}
 
-	return dac[level.u5];
+/* Signed division by 256, truncating towards zero as in C. */
+MIX_AVX2 static __m256i mix_avx2_div256(const __m256i x)
+{
+	return _mm256_srai_epi32(_mm256_add_epi32(x, _mm256_and_si256(
+		_mm256_srai_epi32(x, 31), _mm256_set1_epi32(255))), 8);
 }
 
-void psgplay_digital_to_stereo_linear(struct psgplay *pp,
-	struct psgplay_stereo *stereo, const struct psgplay_digital *digital,
-	size_t count, void *arg)
+/*
+ * Signed division by 256 * 3. The quotient of the division by 256 is less
+ * than 2^17 in magnitude, which is small enough for a single precision
+ * multiplication by 1/3 to truncate exactly as integer division by 3.
+ */
+MIX_AVX2 static __m256i mix_avx2_div768(const __m256i x)
 {
-	struct mixer m = mixer_init(digital, count);
+	return _mm256_cvttps_epi32(_mm256_mul_ps(
+		_mm256_cvtepi32_ps(mix_avx2_div256(x)), _mm256_set1_ps(1.0f / 3)));
+}
 
-	for (size_t i = 0; i < count; i++) {
-		const int16_t sa = psg_dac(digital[i].psg.lva);
-		const int16_t sb = psg_dac(digital[i].psg.lvb);
-		const int16_t sc = psg_dac(digital[i].psg.lvc);
+MIX_AVX2 static __m256i mix_avx2_int16(const __m256i x)
+{
+	return _mm256_srai_epi32(_mm256_slli_epi32(x, 16), 16);
+}
+
+MIX_AVX2 static __m256i mix_avx2_int8(const __m256i x, const int byte)
+{
+	return _mm256_srai_epi32(_mm256_slli_epi32(x, 24 - 8 * byte), 24);
+}
+
+MIX_AVX2 static __m256i mix_avx2_select(const __m256i a, const __m256i b,
+	const __m256i mask)
+{
+	return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(a),
+		_mm256_castsi256_ps(b), _mm256_castsi256_ps(mask)));
+}
+
+/*
+ * The 32 DAC levels fit in four registers, so they are looked up with
+ * permutations, which are much faster than gathers.
+ */
+MIX_AVX2 static __m256i mix_avx2_dac(const __m256i level)
+{
+	const __m256i *dac = (const __m256i *)psg_dac_level;
+	const __m256i bit3 = _mm256_slli_epi32(level, 28);
+	const __m256i bit4 = _mm256_slli_epi32(level, 27);
+
+	return mix_avx2_select(
+		mix_avx2_select(
+			_mm256_permutevar8x32_epi32(
+				_mm256_loadu_si256(&dac[0]), level),
+			_mm256_permutevar8x32_epi32(
+				_mm256_loadu_si256(&dac[1]), level), bit3),
+		mix_avx2_select(
+			_mm256_permutevar8x32_epi32(
+				_mm256_loadu_si256(&dac[2]), level),
+			_mm256_permutevar8x32_epi32(
+				_mm256_loadu_si256(&dac[3]), level), bit3),
+		bit4);
+}
 
-		/* Simplistic linear channel mix. */
-		const int16_t s = digital->mixer.mix ? (sa + sb + sc) / 3 : 0;
+/* Pairs of 16-bit values, with @lo and @hi sign extended to 32 bits. */
+MIX_AVX2 static __m256i mix_avx2_pair(const __m256i lo, const __m256i hi)
+{
+	return _mm256_blend_epi16(lo, _mm256_slli_epi32(hi, 16), 0xaa);
+}
+
+/* Multiplies and adds 16-bit pairs of @x and of the factors @lo and @hi. */
+MIX_AVX2 static __m256i mix_avx2_madd(const __m256i x, const int lo, const int hi)
+{
+	return _mm256_madd_epi16(x, _mm256_set1_epi32((hi << 16) | lo));
+}
+
+MIX_AVX2 static __m256i mix_avx2_weight(const __m256i ab, const __m256i c,
+	const struct mix_weight w)
+{
+	return mix_avx2_int16(mix_avx2_div768(_mm256_add_epi32(
+		mix_avx2_madd(ab, w.a, w.b),
+		mix_avx2_madd(c, w.c, 0))));
+}
+
+MIX_AVX2 static __m256i mix_avx2_gain(const __m256i x, const __m256i volume)
+{
+	const __m256i index = _mm256_min_epi32(_mm256_max_epi32(
+		_mm256_sub_epi32(_mm256_setzero_si256(), volume),
+		_mm256_setzero_si256()),
+		_mm256_set1_epi32(ARRAY_SIZE(mixer_gain) - 1));
+	const __m256 gain = _mm256_i32gather_ps(mixer_gain, index, 4);
+
+	return _mm256_cvttps_epi32(_mm256_mul_ps(
+		_mm256_mul_ps(gain, _mm256_cvtepi32_ps(x)),
+		_mm256_set1_ps(1.0f / 256)));
+}
+
+/* PSG levels and DMA sound of two samples, interleaved. */
+MIX_AVX2 static __m128i mix_avx2_psg_sound(const struct psgplay_digital *d)
+{
+	return _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)&d[0]),
+		_mm_loadl_epi64((const __m128i *)&d[1]));
+}
+
+MIX_AVX2 static size_t mix_avx2(const struct mix *mix,
+	struct psgplay_stereo *stereo, const struct psgplay_digital *digital,
+	const size_t count)
+{
+	const __m256i offset = _mm256_mullo_epi32(
+		_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+		_mm256_set1_epi32(sizeof(*digital)));
+	size_t i;
+
+	BUILD_BUG_ON(offsetof(struct psgplay_digital, psg) != 0);
+	BUILD_BUG_ON(offsetof(struct psgplay_digital, sound) != 4);
+	BUILD_BUG_ON(offsetof(struct psgplay_digital, mixer.volume.left) !=
+		     offsetof(struct psgplay_digital, mixer.volume.main) + 1);
+	BUILD_BUG_ON(offsetof(struct psgplay_digital, mixer.volume.right) !=
+		     offsetof(struct psgplay_digital, mixer.volume.main) + 2);
+	BUILD_BUG_ON(sizeof(struct psgplay_stereo) != 4);
+	BUILD_BUG_ON(offsetof(struct psgplay_stereo, right) != 2);
+
+	for (i = 0; i + 8 <= count; i += 8) {
+		const uint8_t *d = (const uint8_t *)&digital[i];
+		const __m256i psg_sound_0145 = _mm256_setr_m128i(
+			mix_avx2_psg_sound(&digital[i + 0]),
+			mix_avx2_psg_sound(&digital[i + 4]));
+		const __m256i psg_sound_2367 = _mm256_setr_m128i(
+			mix_avx2_psg_sound(&digital[i + 2]),
+			mix_avx2_psg_sound(&digital[i + 6]));
+		const __m256i psg = _mm256_castps_si256(_mm256_shuffle_ps(
+			_mm256_castsi256_ps(psg_sound_0145),
+			_mm256_castsi256_ps(psg_sound_2367), 0x88));
+		const __m256i sound = _mm256_castps_si256(_mm256_shuffle_ps(
+			_mm256_castsi256_ps(psg_sound_0145),
+			_mm256_castsi256_ps(psg_sound_2367), 0xdd));
+		const __m256i a = mix_avx2_level(psg, 0);
+		const __m256i b = mix_avx2_level(psg, 1);
+		const __m256i c = mix_avx2_level(psg, 2);
+		__m256i psg_left, psg_right;
+
+		if (mix->psg && mix->lvl) {
+			/* Levels are gathered in pairs, within the table. */
+			const __m256i index = _mm256_or_si256(a, _mm256_or_si256(
+				_mm256_slli_epi32(b, 5), _mm256_slli_epi32(c, 10)));
+			const __m256i pair = _mm256_i32gather_epi32(
+				(const int *)mix->lvl,
+				_mm256_srli_epi32(index, 1), 4);
+			const __m256i lvl = _mm256_and_si256(_mm256_srlv_epi32(
+				pair, _mm256_slli_epi32(_mm256_and_si256(index,
+					_mm256_set1_epi32(1)), 4)),
+				_mm256_set1_epi32(0xffff));
+
+			psg_left = psg_right = _mm256_sub_epi32(lvl,
+				_mm256_set1_epi32(0x8000));
+		} else if (mix->psg) {
+			const __m256i da = mix_avx2_dac(a);
+			const __m256i db = mix_avx2_dac(b);
+			const __m256i dc = mix_avx2_dac(c);
+
+			const __m256i dab = mix_avx2_pair(da, db);
+
+			psg_left = mix_avx2_weight(dab, dc, mix->weight[0]);
+			psg_right = mix->stereo ? mix_avx2_weight(
+				dab, dc, mix->weight[1]) : psg_left;
+		} else
+			psg_left = psg_right = _mm256_setzero_si256();
+
+		__m256i left = mix_avx2_madd(mix_avx2_pair(sound, psg_left),
+			MIX_SOUND, MIX_PSG);
+		__m256i right = mix_avx2_madd(mix_avx2_pair(
+			_mm256_srli_epi32(sound, 16), psg_right),
+			MIX_SOUND, MIX_PSG);
+
+		if (mix->enable) {
+			const __m256i volume = _mm256_i32gather_epi32(
+				(const int *)&d[offsetof(struct psgplay_digital,
+					mixer.volume)], offset, 1);
+			const __m256i main = mix_avx2_int8(volume, 0);
+
+			left  = mix_avx2_gain(left, _mm256_add_epi32(main,
+				mix_avx2_int8(volume, 1)));
+			right = mix_avx2_gain(right, _mm256_add_epi32(main,
+				mix_avx2_int8(volume, 2)));
+		} else {
+			left  = mix_avx2_div256(left);
+			right = mix_avx2_div256(right);
+		}
 
-		stereo[i] = stereo_mix(&m, s, s, digital[i]);
+		_mm256_storeu_si256((__m256i *)&stereo[i],
+			_mm256_blend_epi16(left, _mm256_slli_epi32(right, 16),
+				0xaa));
 	}
+
+	return i;
+}
+#endif /* HAVE_AVX2 */
+
+static void mix_digital_to_stereo(const struct mix *mix,
+	struct psgplay_stereo *stereo, const struct psgplay_digital *digital,
+	const size_t count)
+{
+	size_t i = 0;
+
+#ifdef HAVE_AVX2
+	if (__builtin_cpu_supports("avx2"))
+		i = mix_avx2(mix, stereo, digital, count);
+#endif
+
+	mix_scalar(mix, &stereo[i], &digital[i], count - i);
+}
+
+void psgplay_digital_to_stereo_linear(struct psgplay *pp,
+	struct psgplay_stereo *stereo, const struct psgplay_digital *digital,
+	size_t count, void *arg)
+{
+	/* Simplistic linear channel mix. */
+	const struct mix_weight w = { 256, 256, 256 };
+	const struct mix mix = mix_init(digital, count, NULL, w, w);
+
+	mix_digital_to_stereo(&mix, stereo, digital, count);
 }
 
 void psgplay_digital_to_stereo_balance(struct psgplay *pp,
@@ -276,27 +586,18 @@ void psgplay_digital_to_stereo_balance(struct psgplay *pp,
 	size_t count, void *arg)
 {
 	struct psgplay_psg_stereo_balance *w = arg;
-	struct mixer m = mixer_init(digital, count);
 
 #define BALANCE(ch, op) (int)(clamp(256.f * (1.f op w->ch), 0.f, 256.f) + 0.5f)
-	const int la = BALANCE(a, -), ra = BALANCE(a, +);
-	const int lb = BALANCE(b, -), rb = BALANCE(b, +);
-	const int lc = BALANCE(c, -), rc = BALANCE(c, +);
+	const struct mix_weight left = {
+		BALANCE(a, -), BALANCE(b, -), BALANCE(c, -)
+	};
+	const struct mix_weight right = {
+		BALANCE(a, +), BALANCE(b, +), BALANCE(c, +)
+	};
 #undef BALANCE
+	const struct mix mix = mix_init(digital, count, NULL, left, right);
 
-	for (size_t i = 0; i < count; i++) {
-		const int16_t sa = psg_dac(digital[i].psg.lva);
-		const int16_t sb = psg_dac(digital[i].psg.lvb);
-		const int16_t sc = psg_dac(digital[i].psg.lvc);
-
-		if (digital->mixer.mix) {
-			const int16_t sl = (la*sa + lb*sb + lc*sc) / (256 * 3);
-			const int16_t sr = (ra*sa + rb*sb + rc*sc) / (256 * 3);
-
-			stereo[i] = stereo_mix(&m, sl, sr, digital[i]);
-		} else
-			stereo[i] = stereo_mix(&m, 0, 0, digital[i]);
-	}
+	mix_digital_to_stereo(&mix, stereo, digital, count);
 }
 
 void psgplay_digital_to_stereo_volume(struct psgplay *pp,
@@ -304,42 +605,24 @@ void psgplay_digital_to_stereo_volume(struct psgplay *pp,
 	size_t count, void *arg)
 {
 	struct psgplay_psg_stereo_volume *w = arg;
-	struct mixer m = mixer_init(digital, count);
 
 #define VOLUME(ch) (int)clamp(256.f * w->ch, 0.f, 256.f)
-	const int va = VOLUME(a);
-	const int vb = VOLUME(b);
-	const int vc = VOLUME(c);
+	const struct mix_weight v = { VOLUME(a), VOLUME(b), VOLUME(c) };
 #undef VOLUME
+	const struct mix mix = mix_init(digital, count, NULL, v, v);
 
-	for (size_t i = 0; i < count; i++) {
-		const int16_t sa = psg_dac(digital[i].psg.lva);
-		const int16_t sb = psg_dac(digital[i].psg.lvb);
-		const int16_t sc = psg_dac(digital[i].psg.lvc);
-
-		const int16_t s = digital->mixer.mix ?
-			(va*sa + vb*sb + vc*sc) / (256 * 3) : 0;
-
-		stereo[i] = stereo_mix(&m, s, s, digital[i]);
-	}
+	mix_digital_to_stereo(&mix, stereo, digital, count);
 }
 
 void psgplay_digital_to_stereo_empiric(struct psgplay *pp,
 	struct psgplay_stereo *stereo, const struct psgplay_digital *digital,
 	size_t count, void *arg)
 {
-	struct mixer m = mixer_init(digital, count);
-
-	cf2149_atari_st_dac(&pp->dac);
+	const struct mix_weight w = { };
+	const struct mix mix = mix_init(digital, count,
+		&pp->dac->lvl[0][0][0], w, w);
 
-	for (size_t i = 0; i < count; i++) {
-		const int16_t s = digital->mixer.mix ?
-			pp->dac.lvl[digital[i].psg.lvc.u5]
-				   [digital[i].psg.lvb.u5]
-				   [digital[i].psg.lva.u5] - 0x8000 : 0;
-
-		stereo[i] = stereo_mix(&m, s, s, digital[i]);
-	}
+	mix_digital_to_stereo(&mix, stereo, digital, count);
 }
 
 void psgplay_digital_to_stereo_callback(struct psgplay *pp,
@@ -533,6 +816,42 @@ static void record_digital(uint64_t cycle, void *arg)
 		pp->record.play = cycle;
 }
 
+/*
+ * PSG register changes are timed in digital samples from the start of the
+ * tune, such that silence is detected with the samples as they are read.
+ * The envelope shape register restarts the envelope even if unchanged.
+ */
+static void silence_psg_register(struct psgplay_silence *silence,
+	uint64_t record_play, uint64_t cycle, uint8_t reg, uint8_t value)
+{
+	const uint64_t index = cycle / 8;	/* Digital samples are 8 PSG cycles */
+
+	if (silence->psg[reg] == value && reg != 13)
+		return;
+
+	silence->psg[reg] = value;
+
+	if (index > record_play)
+		silence->write = max_t(size_t,
+			silence->write, index - record_play);
+}
+
+static void psg_register(uint64_t cycle,
+	uint8_t reg, uint8_t value, void *arg)
+{
+	struct psgplay *pp = arg;
+
+	silence_psg_register(&pp->silence, pp->record.play, cycle, reg, value);
+
+	if (pp->psg_register_callback.cb)
+		pp->psg_register_callback.cb(pp,
+			&(struct psgplay_psg_register) {
+				.cycle = cycle,
+				.reg = reg,
+				.value = value,
+			}, pp->psg_register_callback.arg);
+}
+
 static uint32_t parse_timer(const void *data, size_t size)
 {
 	struct sndh_timer timer;
@@ -565,10 +884,12 @@ struct psgplay *psgplay_init(const void *data, size_t size,
 		.sound_sample = sound_digital,
 		.mixer_sample = mixer_digital,
 		.record_sample = record_digital,
+		.psg_register = psg_register,
 		.arg = pp
 	};
 
 	pp->record.play = RECORD_PLAY_DEFAULT;
+	pp->dac = cf2149_atari_st_dac();
 	pp->downsample.stereo_frequency = stereo_frequency;
 	pp->machine = (struct machine) {
 		.init = atari_st_init,
@@ -610,11 +931,10 @@ static void digital_buffer_shift(struct digital_buffer *db)
 	db->index = 0;
 }
 
-static ssize_t psgplay_read_digital__(struct psgplay *pp,
-	struct psgplay_digital *buffer, size_t count)
+static ssize_t psgplay_peek_digital__(struct psgplay *pp,
+	const struct psgplay_digital **buffer, size_t count)
 {
 	struct digital_buffer *db = &pp->digital_buffer;
-	size_t index = 0;
 
 	if (db->stop) {
 		if (db->total >= db->stop)
@@ -623,84 +943,274 @@ static ssize_t psgplay_read_digital__(struct psgplay *pp,
 		count = min(count, db->stop - db->total);
 	}
 
-	cpu_instruction_callback(&pp->machine,
-		pp->instruction_callback.cb,
-		pp->instruction_callback.arg);
+	if (digital_buffer_min_count(db) - db->index < count) {
+		digital_buffer_shift(db);
+
+		cpu_instruction_callback(&pp->machine,
+			pp->instruction_callback.cb,
+			pp->instruction_callback.arg);
+
+		while (digital_buffer_min_count(db) < count)
+			if (pp->errno_) {
+				errno = pp->errno_;
+				return -1;
+			} else if (!pp->machine.run(&pp->machine)) {
+				errno = -EIO;
+				return -1;
+			}
+	}
+
+	const size_t n = digital_buffer_min_count(db) - db->index;
+
+	if (buffer != NULL)
+		*buffer = &db->sample[db->index];
+
+	return db->stop ? min(n, db->stop - db->total) : n;
+}
+
+static bool digital_constant(const struct psgplay_digital *a,
+	const struct psgplay_digital *b)
+{
+	return a->psg.lva.u8   == b->psg.lva.u8   &&
+	       a->psg.lvb.u8   == b->psg.lvb.u8   &&
+	       a->psg.lvc.u8   == b->psg.lvc.u8   &&
+	       a->sound.left  == b->sound.left  &&
+	       a->sound.right == b->sound.right;
+}
+
+static void silence_detect(struct psgplay *pp,
+	const struct psgplay_digital *digital, size_t count)
+{
+	struct psgplay_silence *silence = &pp->silence;
+	struct digital_buffer *db = &pp->digital_buffer;
+
+	if (!silence->threshold)
+		return;
+
+	for (size_t i = 0; i < count; i++) {
+		if (!digital_constant(&silence->sample, &digital[i]))
+			silence->start = db->total + i;
+
+		silence->sample = digital[i];
+	}
+
+	const size_t start = max(silence->start, silence->write);
+	const size_t end = db->total + count;
+
+	if (start + silence->threshold <= end &&
+	    (!db->stop || end + FADE_SAMPLES < db->stop))
+		psgplay_stop_digital_at_sample(pp, end);
+}
+
+static void psgplay_consume_digital__(struct psgplay *pp, size_t count)
+{
+	struct digital_buffer *db = &pp->digital_buffer;
+
+	count = min(count, digital_buffer_min_count(db) - db->index);
+
+	silence_detect(pp, &db->sample[db->index], count);
+
+	db->index += count;
+	db->total += count;
+}
+
+static ssize_t psgplay_read_digital__(struct psgplay *pp,
+	struct psgplay_digital *buffer, size_t count)
+{
+	size_t index = 0;
 
 	while (index < count) {
-		if (db->index == digital_buffer_min_count(db)) {
-			digital_buffer_shift(db);
-
-			while (!digital_buffer_min_count(db))
-				if (pp->errno_) {
-					errno = pp->errno_;
-					return -1;
-				} else if (!pp->machine.run(&pp->machine)) {
-					errno = -EIO;
-					return -1;
-				}
-		}
+		const struct psgplay_digital *digital;
+		const ssize_t r = psgplay_peek_digital__(pp, &digital, 1);
+
+		if (r < 0)
+			return r;
+		else if (!r)
+			break;
 
-		const size_t n = min(count - index,
-			digital_buffer_min_count(db) - db->index);
+		const size_t n = min_t(size_t, count - index, r);
 
 		if (buffer != NULL)
-			memcpy(&buffer[index], &db->sample[db->index],
-				n * sizeof(*buffer));
+			memcpy(&buffer[index], digital, n * sizeof(*buffer));
 
+		psgplay_consume_digital__(pp, n);
 		index += n;
-		db->index += n;
-		db->total += n;
 	}
 
 	return index;
 }
 
-ssize_t psgplay_read_stereo(struct psgplay *pp,
-	struct psgplay_stereo *buffer, size_t count)
+ssize_t psgplay_peek_stereo(struct psgplay *pp,
+	const struct psgplay_stereo **buffer)
 {
 	struct stereo_buffer *sb = &pp->stereo_buffer;
-	size_t index = 0;
 
 	if (!pp->downsample.stereo_frequency)
 		return -EINVAL;
 
-	while (index < count) {
-		if (sb->index == sb->count) {
-			sb->index = 0;
-			sb->count = 0;
+	while (sb->index == sb->count) {
+		sb->index = 0;
+		sb->count = 0;
 
-			if (pp->errno_) {
-				errno = pp->errno_;
-				return -1;
-			}
+		if (pp->errno_) {
+			errno = pp->errno_;
+			return -1;
+		}
 
-			struct psgplay_digital d[4096];
-			const ssize_t n = psgplay_read_digital__(
-				pp, d, ARRAY_SIZE(d));
+		/*
+		 * Digital samples are transformed in fixed blocks, since
+		 * the stereo mix depends on the block boundaries.
+		 */
+		const struct psgplay_digital *digital;
+		const ssize_t r = psgplay_peek_digital__(pp, &digital,
+			DIGITAL_TO_STEREO_BLOCK);
 
-			if (n < 0)
-				return n;
-			else if (!n)
-				return index;
+		if (r <= 0)
+			return r;
 
-			digital_to_stereo_downsample(pp, d, n);
-		}
+		const size_t n = min_t(size_t, r, DIGITAL_TO_STEREO_BLOCK);
+
+		psgplay_consume_digital__(pp, n);
+
+		digital_to_stereo_downsample(pp, digital, n);
+	}
+
+	if (buffer != NULL)
+		*buffer = &sb->sample[sb->index];
+
+	return sb->count - sb->index;
+}
+
+void psgplay_consume_stereo(struct psgplay *pp, size_t count)
+{
+	struct stereo_buffer *sb = &pp->stereo_buffer;
+
+	count = min(count, sb->count - sb->index);
+
+	sb->index += count;
+	sb->total += count;
+}
+
+ssize_t psgplay_read_stereo(struct psgplay *pp,
+	struct psgplay_stereo *buffer, size_t count)
+{
+	size_t index = 0;
+
+	while (index < count) {
+		const struct psgplay_stereo *stereo;
+		const ssize_t r = psgplay_peek_stereo(pp, &stereo);
+
+		if (r < 0)
+			return r;
+		else if (!r)
+			break;
 
-		const size_t n = min(count - index, sb->count - sb->index);
+		const size_t n = min_t(size_t, count - index, r);
 
 		if (buffer != NULL)
-			memcpy(&buffer[index], &sb->sample[sb->index],
-				n * sizeof(*buffer));
+			memcpy(&buffer[index], stereo, n * sizeof(*buffer));
 
+		psgplay_consume_stereo(pp, n);
 		index += n;
-		sb->index += n;
-		sb->total += n;
 	}
 
 	return index;
 }
 
+/* Number of digital samples that downsample to less than a given count. */
+static size_t digital_skip_count(const struct psgplay *pp, const size_t count)
+{
+	return count < 2 ? 0 : ((count - 1) * (uint64_t)PSG_FREQUENCY) /
+		(8 * (uint64_t)pp->downsample.stereo_frequency);
+}
+
+static ssize_t psgplay_skip_stereo(struct psgplay *pp, size_t count)
+{
+	struct stereo_buffer *sb = &pp->stereo_buffer;
+	struct psgplay_stereo silence[DIGITAL_TO_STEREO_BLOCK] = { };
+	struct psgplay_stereo resample[ARRAY_SIZE(silence)];
+	size_t index = 0;
+
+	while (index < count) {
+		if (sb->index < sb->count) {
+			const size_t n = min(count - index, sb->count - sb->index);
+
+			psgplay_consume_stereo(pp, n);
+			index += n;
+			continue;
+		}
+
+		const size_t n = min_t(size_t, ARRAY_SIZE(silence),
+			digital_skip_count(pp, count - index));
+
+		/* The last few stereo samples are made in full. */
+		if (!n) {
+			const ssize_t r = psgplay_peek_stereo(pp, NULL);
+
+			if (r < 0)
+				return r;
+			else if (!r)
+				break;
+
+			continue;
+		}
+
+		if (pp->errno_) {
+			errno = pp->errno_;
+			return -1;
+		}
+
+		const ssize_t r = psgplay_peek_digital__(pp, NULL, 1);
+
+		if (r < 0)
+			return r;
+		else if (!r)
+			break;
+
+		const size_t m = min_t(size_t, n, r);
+
+		psgplay_consume_digital__(pp, m);
+
+		/*
+		 * The downsampler is given silence rather than mixed stereo
+		 * samples, to keep its phase without mixing and fading.
+		 */
+		const size_t q = pp->stereo_downsample_callback.cb(resample,
+			silence, m, pp->stereo_downsample_callback.arg);
+		const size_t k = min(count - index, q);
+
+		sb->total += k;
+		index += k;
+
+		/* Resamples beyond the count are kept to be read next. */
+		pp->errno_ = buffer_stereo_sample(sb, &resample[k], q - k);
+	}
+
+	return index;
+}
+
+ssize_t psgplay_skip(struct psgplay *pp, size_t count)
+{
+	if (!pp->downsample.stereo_frequency)
+		return psgplay_read_digital__(pp, NULL, count);
+
+	return psgplay_skip_stereo(pp, count);
+}
+
+ssize_t psgplay_peek_digital(struct psgplay *pp,
+	const struct psgplay_digital **buffer)
+{
+	if (pp->downsample.stereo_frequency)
+		return -EINVAL;
+
+	return psgplay_peek_digital__(pp, buffer, 1);
+}
+
+void psgplay_consume_digital(struct psgplay *pp, size_t count)
+{
+	psgplay_consume_digital__(pp, count);
+}
+
 ssize_t psgplay_read_digital(struct psgplay *pp,
 	struct psgplay_digital *buffer, size_t count)
 {
@@ -735,6 +1245,15 @@ void psgplay_stop_at_time(struct psgplay *pp, float time)
 	psgplay_stop_digital_at_sample(pp, max(0.0f, f * time));
 }
 
+void psgplay_stop_at_silence(struct psgplay *pp, float time)
+{
+	const float f = ATARI_STE_EXT_OSC /
+		(float)(ATARI_STE_SND_PSG_CLK_DIV *
+			ATARI_STE_SND_PSG_MODE8_DIV);
+
+	pp->silence.threshold = max(0.0f, f * time);
+}
+
 void psgplay_stop(struct psgplay *pp)
 {
 	psgplay_stop_at_time(pp, 0);
@@ -751,3 +1270,59 @@ void psgplay_instruction_callback(struct psgplay *pp,
 	pp->instruction_callback.cb = cb;
 	pp->instruction_callback.arg = arg;
 }
+
+void psgplay_psg_register_callback(struct psgplay *pp,
+	psgplay_psg_register_cb cb, void *arg)
+{
+	pp->psg_register_callback.cb = cb;
+	pp->psg_register_callback.arg = arg;
+}
+
+uint64_t psgplay_psg_play_cycle(const struct psgplay *pp)
+{
+	return 8 * pp->record.play;	/* Digital samples are 8 PSG cycles */
+}
+
+static struct psgplay_stats_device stats_device(const uint64_t *slot,
+	uint64_t bus_error)
+{
+	return (struct psgplay_stats_device) {
+		.rom       = slot[DEVICE_SLOT_ROM],
+		.glue      = slot[DEVICE_SLOT_GLUE],
+		.ram       = slot[DEVICE_SLOT_RAM],
+		.mfp       = slot[DEVICE_SLOT_MFP],
+		.shifter   = slot[DEVICE_SLOT_SHIFTER],
+		.psg       = slot[DEVICE_SLOT_PSG],
+		.sound     = slot[DEVICE_SLOT_SOUND],
+		.mixer     = slot[DEVICE_SLOT_MIXER],
+		.fdc       = slot[DEVICE_SLOT_FDC],
+		.bus_error = bus_error,
+	};
+}
+
+int psgplay_stats(const struct psgplay *pp, struct psgplay_stats *stats)
+{
+	const struct machine_stats *ms = &pp->machine.stats;
+
+	*stats = (struct psgplay_stats) {
+		.instructions = ms->instructions,
+		.cpu_cycles = ms->cpu_cycles,
+		.bus = stats_device(ms->bus, ms->bus_error),
+		.event = stats_device(ms->event, 0),
+		.dma_sound_bytes = ms->dma_sound_bytes,
+		.reallocation = {
+			.stereo = pp->stereo_buffer.reallocations,
+			.digital = pp->digital_buffer.reallocations,
+		},
+	};
+
+	for (int i = 0; i < ARRAY_SIZE(stats->interrupt); i++)
+		stats->interrupt[i] = ms->interrupt[i];
+
+#ifdef HAVE_STATS
+	return 0;
+#else
+	errno = ENOSYS;
+	return -1;
+#endif
+}
@@ -0,0 +1,190 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (C) 2026 Fredrik Noring
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "internal/build-assert.h"
+#include "internal/compare.h"
+#include "internal/psgplay.h"
+
+#include "psgplay/digital.h"
+#include "psgplay/psgplay.h"
+
+/* RAM is stored apart from the rest of the state, by written pages only. */
+#define RAM_OFFSET offsetof(struct psgplay, machine.ram.u8)
+#define RAM_END (RAM_OFFSET + sizeof(((struct psgplay *)0)->machine.ram.u8))
+#define RAM_PAGE_SIZE (1 << MACHINE_RAM_PAGE_SHIFT)
+
+struct psgplay_snapshot {
+	const struct psgplay *pp;
+
+	uint8_t state[sizeof(struct psgplay) - MACHINE_RAM_SIZE];
+	uint32_t dirty[MACHINE_RAM_PAGE_COUNT / 32];
+
+	struct psgplay_stereo *stereo;
+	struct psgplay_digital *digital;
+
+	uint8_t (*page)[RAM_PAGE_SIZE];
+};
+
+static bool ram_page_dirty(const uint32_t *dirty, uint32_t page)
+{
+	return dirty[page / 32] & (1u << (page % 32));
+}
+
+static size_t ram_page_count(const uint32_t *dirty)
+{
+	size_t n = 0;
+
+	for (uint32_t page = 0; page < MACHINE_RAM_PAGE_COUNT; page++)
+		if (ram_page_dirty(dirty, page))
+			n++;
+
+	return n;
+}
+
+static size_t digital_count(const struct digital_buffer *db)
+{
+	return max3(db->count.psg, db->count.sound, db->count.mixer);
+}
+
+static void *memdup(const void *p, size_t size)
+{
+	void *q = size ? malloc(size) : NULL;
+
+	if (q)
+		memcpy(q, p, size);
+
+	return q;
+}
+
+struct psgplay_snapshot *psgplay_snapshot(const struct psgplay *pp)
+{
+	const struct stereo_buffer *sb = &pp->stereo_buffer;
+	const struct digital_buffer *db = &pp->digital_buffer;
+	const size_t page_count = ram_page_count(pp->machine.ram.dirty);
+	struct psgplay_snapshot *snapshot =
+		calloc(1, sizeof(struct psgplay_snapshot));
+
+	BUILD_BUG_ON(RAM_END - RAM_OFFSET != MACHINE_RAM_SIZE);
+
+	if (!snapshot)
+		return NULL;
+
+	snapshot->pp = pp;
+	memcpy(snapshot->dirty, pp->machine.ram.dirty, sizeof(snapshot->dirty));
+
+	memcpy(&snapshot->state[0], pp, RAM_OFFSET);
+	memcpy(&snapshot->state[RAM_OFFSET], (const uint8_t *)pp + RAM_END,
+		sizeof(struct psgplay) - RAM_END);
+
+	snapshot->stereo = memdup(sb->sample,
+		sb->count * sizeof(*sb->sample));
+	snapshot->digital = memdup(db->sample,
+		digital_count(db) * sizeof(*db->sample));
+	snapshot->page = page_count ?
+		malloc(page_count * sizeof(*snapshot->page)) : NULL;
+
+	if ((sb->count && !snapshot->stereo) ||
+	    (digital_count(db) && !snapshot->digital) ||
+	    (page_count && !snapshot->page)) {
+		psgplay_snapshot_free(snapshot);
+		return NULL;
+	}
+
+	for (uint32_t page = 0, i = 0; page < MACHINE_RAM_PAGE_COUNT; page++)
+		if (ram_page_dirty(snapshot->dirty, page))
+			memcpy(snapshot->page[i++],
+				&pp->machine.ram.u8[page * RAM_PAGE_SIZE],
+				RAM_PAGE_SIZE);
+
+	return snapshot;
+}
+
+int psgplay_restore(struct psgplay *pp,
+	const struct psgplay_snapshot *snapshot)
+{
+	if (snapshot->pp != pp) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/*
+	 * Pages written since the snapshot was taken are cleared, since
+	 * they were zero unless written before the snapshot.
+	 */
+	for (uint32_t page = 0, i = 0; page < MACHINE_RAM_PAGE_COUNT; page++)
+		if (ram_page_dirty(snapshot->dirty, page))
+			memcpy(&pp->machine.ram.u8[page * RAM_PAGE_SIZE],
+				snapshot->page[i++], RAM_PAGE_SIZE);
+		else if (ram_page_dirty(pp->machine.ram.dirty, page))
+			memset(&pp->machine.ram.u8[page * RAM_PAGE_SIZE],
+				0, RAM_PAGE_SIZE);
+
+	/*
+	 * Buffers never shrink, so they have at least the capacity they had
+	 * when the snapshot was taken. Callbacks, tracing and statistics are
+	 * retained.
+	 */
+	struct stereo_buffer sb = pp->stereo_buffer;
+	struct digital_buffer db = pp->digital_buffer;
+	const typeof(pp->digital_to_stereo_callback) digital_to_stereo_callback =
+		pp->digital_to_stereo_callback;
+	const typeof(pp->stereo_downsample_callback) stereo_downsample_callback =
+		pp->stereo_downsample_callback;
+	const typeof(pp->instruction_callback) instruction_callback =
+		pp->instruction_callback;
+	const typeof(pp->psg_register_callback) psg_register_callback =
+		pp->psg_register_callback;
+	struct trace_mode *trace = pp->machine.trace;
+	const uint32_t trace_device = pp->machine.trace_device;
+	const struct machine_stats stats = pp->machine.stats;
+
+	memcpy(pp, &snapshot->state[0], RAM_OFFSET);
+	memcpy((uint8_t *)pp + RAM_END, &snapshot->state[RAM_OFFSET],
+		sizeof(struct psgplay) - RAM_END);
+
+	sb.index = pp->stereo_buffer.index;
+	sb.count = pp->stereo_buffer.count;
+	sb.total = pp->stereo_buffer.total;
+	if (sb.count)
+		memcpy(sb.sample, snapshot->stereo,
+			sb.count * sizeof(*sb.sample));
+	pp->stereo_buffer = sb;
+
+	db.index = pp->digital_buffer.index;
+	db.count.psg = pp->digital_buffer.count.psg;
+	db.count.sound = pp->digital_buffer.count.sound;
+	db.count.mixer = pp->digital_buffer.count.mixer;
+	db.total = pp->digital_buffer.total;
+	db.stop = pp->digital_buffer.stop;
+	if (digital_count(&db))
+		memcpy(db.sample, snapshot->digital,
+			digital_count(&db) * sizeof(*db.sample));
+	pp->digital_buffer = db;
+
+	pp->digital_to_stereo_callback = digital_to_stereo_callback;
+	pp->stereo_downsample_callback = stereo_downsample_callback;
+	pp->instruction_callback = instruction_callback;
+	pp->psg_register_callback = psg_register_callback;
+	pp->machine.trace = trace;
+	pp->machine.trace_device = trace_device;
+	pp->machine.stats = stats;
+
+	return 0;
+}
+
+void psgplay_snapshot_free(struct psgplay_snapshot *snapshot)
+{
+	if (!snapshot)
+		return;
+
+	free(snapshot->stereo);
+	free(snapshot->digital);
+	free(snapshot->page);
+	free(snapshot);
+}
@@ -0,0 +1,185 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (C) 2026 Fredrik Noring
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include "internal/build-assert.h"
+#include "internal/compare.h"
+#include "internal/types.h"
+
+#include "atari/psg.h"
+
+#include "psgplay/ym.h"
+
+#define YM_REGISTERS 16
+#define YM_ENVELOPE_SHAPE 13
+#define YM_ATTRIBUTE_INTERLEAVED 1
+
+struct ym_buffer {
+	uint8_t *b;
+	size_t size;
+	size_t length;
+};
+
+static void put_at(struct ym_buffer *yb, size_t offset, uint8_t value)
+{
+	if (offset < yb->size)
+		yb->b[offset] = value;
+}
+
+static void put_u8(struct ym_buffer *yb, uint8_t value)
+{
+	put_at(yb, yb->length++, value);
+}
+
+static void put_u16(struct ym_buffer *yb, uint16_t value)
+{
+	put_u8(yb, value >> 8);
+	put_u8(yb, value);
+}
+
+static void put_u32(struct ym_buffer *yb, uint32_t value)
+{
+	put_u16(yb, value >> 16);
+	put_u16(yb, value);
+}
+
+static void put_magic(struct ym_buffer *yb, const char *s)
+{
+	for (; *s; s++)
+		put_u8(yb, *s);
+}
+
+static void put_string(struct ym_buffer *yb, const char *s)
+{
+	put_magic(yb, s ? s : "");
+	put_u8(yb, '\0');
+}
+
+static void put_leb128(struct ym_buffer *yb, uint64_t value)
+{
+	for (; value >= 0x80; value >>= 7)
+		put_u8(yb, 0x80 | (value & 0x7f));
+
+	put_u8(yb, value);
+}
+
+size_t psgplay_psg_register_log(void *buf, size_t size, uint64_t start,
+	const struct psgplay_psg_register *reg, size_t count)
+{
+	struct ym_buffer yb = { .b = buf, .size = size };
+	uint64_t previous = start;
+
+	BUILD_BUG_ON(PSG_FREQUENCY != PSGPLAY_PSG_FREQUENCY);
+
+	put_magic(&yb, "PSGR");
+	put_u32(&yb, PSGPLAY_PSG_FREQUENCY);
+
+	for (size_t i = 0; i < count; i++) {
+		const uint64_t cycle = max(reg[i].cycle, previous);
+
+		put_leb128(&yb, cycle - previous);
+		put_u8(&yb, reg[i].reg);
+		put_u8(&yb, reg[i].value);
+
+		previous = cycle;
+	}
+
+	return yb.length;
+}
+
+static uint64_t ym_frame_cycle(const struct psgplay_ym *ym, size_t frame)
+{
+	return ym->start +
+		(frame * (uint64_t)PSGPLAY_PSG_FREQUENCY) / ym->frame_rate;
+}
+
+static size_t ym_frame_count(const struct psgplay_ym *ym,
+	const struct psgplay_psg_register *reg, size_t count)
+{
+	if (ym->frame_count || !count)
+		return ym->frame_count;
+
+	const uint64_t cycle = reg[count - 1].cycle;
+
+	/* Frame of the last write, consistent with ym_frame_cycle(). */
+	return cycle < ym->start ? 1 : 1 + ((cycle - ym->start + 1) *
+		ym->frame_rate - 1) / PSGPLAY_PSG_FREQUENCY;
+}
+
+static uint8_t ym_register_mask(const int r)
+{
+	static const uint8_t mask[YM_REGISTERS] = {
+		0xff, 0x0f, 0xff, 0x0f, 0xff, 0x0f, 0x1f, 0xff,
+		0x1f, 0x1f, 0x1f, 0xff, 0xff, 0x0f, 0x00, 0x00,
+	};
+
+	return mask[r];
+}
+
+ssize_t psgplay_ym(void *buf, size_t size, const struct psgplay_ym *ym,
+	const struct psgplay_psg_register *reg, size_t count)
+{
+	if ((ym->version != 5 && ym->version != 6) ||
+	    ym->frame_rate < 1 || 0xffff < ym->frame_rate) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	const size_t frame_count = ym_frame_count(ym, reg, count);
+
+	if ((frame_count && frame_count <= ym->loop_frame) ||
+	    UINT32_MAX < (uint64_t)frame_count) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	struct ym_buffer yb = { .b = buf, .size = size };
+
+	put_magic(&yb, ym->version == 5 ? "YM5!" : "YM6!");
+	put_magic(&yb, "LeOnArD!");
+	put_u32(&yb, frame_count);
+	put_u32(&yb, YM_ATTRIBUTE_INTERLEAVED);
+	put_u16(&yb, 0);	/* No digidrums */
+	put_u32(&yb, PSGPLAY_PSG_FREQUENCY);
+	put_u16(&yb, ym->frame_rate);
+	put_u32(&yb, ym->loop_frame);
+	put_u16(&yb, 0);	/* No additional data */
+
+	put_string(&yb, ym->title);
+	put_string(&yb, ym->author);
+	put_string(&yb, ym->comment);
+
+	const size_t data = yb.length;
+	uint8_t state[YM_REGISTERS] = { };
+	bool shape = false;
+
+	for (size_t frame = 0, i = 0; frame < frame_count; frame++) {
+		const uint64_t end = ym_frame_cycle(ym, frame + 1);
+
+		for (; i < count && reg[i].cycle < end; i++) {
+			if (reg[i].reg >= YM_REGISTERS)
+				continue;
+
+			state[reg[i].reg] = reg[i].value;
+			if (reg[i].reg == YM_ENVELOPE_SHAPE)
+				shape = true;
+		}
+
+		for (int r = 0; r < YM_REGISTERS; r++)
+			put_at(&yb, data + r * frame_count + frame,
+				r == YM_ENVELOPE_SHAPE && !shape ? 0xff :
+					state[r] & ym_register_mask(r));
+
+		shape = false;
+	}
+
+	yb.length += YM_REGISTERS * frame_count;
+
+	put_magic(&yb, "End!");
+
+	return yb.length;
+}
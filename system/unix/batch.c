@@ -0,0 +1,886 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (C) 2026 Fredrik Noring
+ *
+ * Render SNDH files and their tracks in parallel, for example a whole
+ * archive, to WAVE or raw files.
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "internal/compare.h"
+#include "internal/macro.h"
+#include "internal/print.h"
+#include "internal/string.h"
+#include "internal/types.h"
+
+#include "psgplay/loop.h"
+#include "psgplay/psgplay.h"
+#include "psgplay/sndh.h"
+#include "psgplay/stereo.h"
+#include "psgplay/version.h"
+
+#include "audio/raw-writer.h"
+#include "audio/wave-writer.h"
+
+#include "system/unix/cache.h"
+#include "system/unix/file.h"
+#include "system/unix/memory.h"
+#include "system/unix/sndh.h"
+#include "system/unix/string.h"
+
+const char *progname = "psgplay-batch";
+
+struct batch_options {
+	const char *archive;
+	const char *output;
+	float length;
+	float silence;
+	int frequency;
+	int jobs;
+	bool detect_loop;
+	bool raw;
+	struct cache cache;
+};
+
+/**
+ * struct batch_file - SNDH file to render
+ * @path: path of file to read
+ * @name: name relative to the archive or directory, used for output
+ * @track_count: number of tracks to render, or 0 for all tracks
+ * @file: file contents, shared by all tracks once read
+ * @refs: number of tracks remaining to render
+ */
+struct batch_file {
+	char *path;
+	char *name;
+	int track_count;
+	struct file file;
+	int refs;
+};
+
+/**
+ * struct batch_task - track to render
+ * @file: file of track
+ * @track: track to render, or 0 to read the file and render all its tracks
+ */
+struct batch_task {
+	struct batch_file *file;
+	int track;
+};
+
+struct batch_queue {
+	pthread_mutex_t lock;
+	size_t head;
+	size_t tail;
+	size_t capacity;
+	struct batch_task *task;
+};
+
+struct batch_worker {
+	struct batch *batch;
+	struct batch_queue queue;
+	pthread_t thread;
+	size_t index;
+};
+
+struct batch {
+	const struct batch_options *options;
+
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	uint64_t generation;
+	size_t pending;
+
+	size_t ok_count;
+	size_t fail_count;
+
+	size_t worker_count;
+	struct batch_worker *worker;
+};
+
+static void help(FILE *file)
+{
+	fprintf(file,
+"Usage: %s [options]... <sndh-file|manifest|directory>...\n"
+"\n"
+"Render all tracks of SNDH files in parallel. A manifest lists one SNDH\n"
+"file per line, prefixed with its number of tracks, as test/archive.suite.\n"
+"A directory is searched recursively for files with the .sndh extension.\n"
+"\n"
+"Options:\n"
+"\n"
+"    -h, --help             display this help and exit\n"
+"    --version              display version and exit\n"
+"\n"
+"    -a, --archive=<dir>    directory of files named in manifests\n"
+"    -o, --output=<dir>     directory to write audio files to (default .)\n"
+"    -j, --jobs=<num>       number of worker threads (default all CPUs)\n"
+"    -f, --frequency=<num>  set audio frequency in Hz (default 44100)\n"
+"    --length=<[mm:]ss.ss>  length of tracks without known duration\n"
+"                           (default 3:00)\n"
+"    --silence=<[mm:]ss.ss> stop rendering tracks after the given duration\n"
+"                           of silence, and pad them with silence\n"
+"    --detect-loop          detect when tracks without known duration loop\n"
+"                           or end, within the length, to render them once\n"
+"    --raw                  write headerless 16-bit little-endian stereo\n"
+"                           instead of the WAVE format\n"
+"    --cache=<dir>          cache rendered audio in the directory, to\n"
+"                           replay it without emulation\n"
+"    --cache-size=<MiB>     remove the least recently used cached audio when\n"
+"                           the cache exceeds the size (default 1024)\n"
+"\n"
+"Each rendered track is reported on standard output as\n"
+"\n"
+"    track <ok|fail> <seconds elapsed> <seconds of audio> <track> <file>\n"
+"\n"
+"followed by a summary when all tracks are done\n"
+"\n"
+"    batch <ok count> <fail count> <seconds elapsed>\n"
+"\n"
+"Failed tracks are also reported on standard error, and do not stop the\n"
+"batch. The exit status is nonzero if any track failed.\n",
+		progname);
+}
+
+static void NORETURN help_exit(int code)
+{
+	help(code == EXIT_SUCCESS ? stdout : stderr);
+
+	exit(code);
+}
+
+static void NORETURN version_exit(void)
+{
+	printf("%s version %s\n", progname, psgplay_version());
+
+	exit(EXIT_SUCCESS);
+}
+
+static float parse_time(const char *s)
+{
+	float a, b;
+	const int r = sscanf(s, "%f:%f", &a, &b);
+
+	if (r < 1)
+		pr_fatal_error("malformed time '%s'\n", s);
+
+	return r == 2 ? 60.0f * a + b : a;
+}
+
+static int default_jobs(void)
+{
+	const long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return n > 0 ? n : 1;
+}
+
+static struct batch_options parse_options(int argc, char **argv)
+{
+	static const struct option options[] = {
+		{ "help",       no_argument,       NULL, 0 },
+		{ "version",    no_argument,       NULL, 0 },
+
+		{ "archive",    required_argument, NULL, 0 },
+		{ "output",     required_argument, NULL, 0 },
+		{ "jobs",       required_argument, NULL, 0 },
+		{ "frequency",  required_argument, NULL, 0 },
+		{ "length",     required_argument, NULL, 0 },
+		{ "silence",    required_argument, NULL, 0 },
+		{ "detect-loop", no_argument,      NULL, 0 },
+		{ "raw",        no_argument,       NULL, 0 },
+		{ "cache",      required_argument, NULL, 0 },
+		{ "cache-size", required_argument, NULL, 0 },
+
+		{ NULL, 0, NULL, 0 }
+	};
+
+	struct batch_options option = {
+		.output = ".",
+		.length = 180.0f,
+		.frequency = 44100,
+		.jobs = default_jobs(),
+		.cache.size_limit = CACHE_SIZE_DEFAULT,
+	};
+
+#define OPT(option) (strcmp(options[index].name, (option)) == 0)
+
+	argv[0] = (char *)progname;	/* For better getopt_long messages. */
+
+	for (;;) {
+		int index = 0;
+
+		switch (getopt_long(argc, argv,
+			"ha:o:j:f:", options, &index)) {
+		case -1:
+			if (optind == argc)
+				help_exit(EXIT_FAILURE);
+			goto out;
+
+		case 0:
+			if (OPT("help"))
+				goto opt_h;
+			else if (OPT("version"))
+				version_exit();
+
+			else if (OPT("archive"))
+				goto opt_a;
+			else if (OPT("output"))
+				goto opt_o;
+			else if (OPT("jobs"))
+				goto opt_j;
+			else if (OPT("frequency"))
+				goto opt_f;
+			else if (OPT("length"))
+				option.length = parse_time(optarg);
+			else if (OPT("silence"))
+				option.silence = parse_time(optarg);
+			else if (OPT("detect-loop"))
+				option.detect_loop = true;
+			else if (OPT("raw"))
+				option.raw = true;
+			else if (OPT("cache"))
+				option.cache.dir = optarg;
+			else if (OPT("cache-size"))
+				option.cache.size_limit =
+					cache_size_option(optarg);
+			break;
+
+		case 'h':
+opt_h:			help_exit(EXIT_SUCCESS);
+
+		case 'a':
+opt_a:			option.archive = optarg;
+			break;
+
+		case 'o':
+opt_o:			option.output = optarg;
+			break;
+
+		case 'j':
+opt_j:			option.jobs = atoi(optarg);
+			break;
+
+		case 'f':
+opt_f:			option.frequency = atoi(optarg);
+			break;
+
+		case '?':
+			exit(EXIT_FAILURE);
+		}
+	}
+
+#undef OPT
+out:
+	if (option.jobs < 1)
+		pr_fatal_error("invalid number of jobs: %d\n", option.jobs);
+	if (option.frequency <= 0)
+		pr_fatal_error("invalid frequency: %d\n", option.frequency);
+	if (option.length <= 0)
+		pr_fatal_error("invalid length: %f\n", option.length);
+	if (option.silence < 0)
+		pr_fatal_error("invalid silence: %f\n", option.silence);
+
+	return option;
+}
+
+static uint64_t clock_ns(void)
+{
+	struct timespec tp;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &tp) == -1)
+		pr_fatal_errno("clock_ns:clock_gettime");
+
+	return tp.tv_sec * 1000000000ull + tp.tv_nsec;
+}
+
+static char *path_join(const char *dir, const char *name)
+{
+	struct strbuf sb = { };
+
+	if (!(!dir || !dir[0] ? sbprintf(&sb, "%s", name) :
+	      !name[0]        ? sbprintf(&sb, "%s", dir) :
+				sbprintf(&sb, "%s/%s", dir, name)))
+		pr_fatal_errno("path_join");
+
+	return sb.s;
+}
+
+static bool sndh_extension(const char *name)
+{
+	const size_t length = strlen(name);
+
+	return length > 5 && strcasecmp(&name[length - 5], ".sndh") == 0;
+}
+
+static void file_list_add(struct batch_file **list, size_t *count,
+	char *path, char *name, int track_count)
+{
+	*list = xrealloc(*list, (*count + 1) * sizeof(**list));
+	(*list)[(*count)++] = (struct batch_file) {
+		.path = path,
+		.name = name,
+		.track_count = track_count,
+	};
+}
+
+static void file_list_directory(struct batch_file **list, size_t *count,
+	const char *dir, const char *name)
+{
+	char *path = path_join(dir, name);
+	DIR *d = opendir(path);
+
+	if (!d)
+		pr_fatal_errno(path);
+
+	for (struct dirent *e; (e = readdir(d)); ) {
+		struct stat st;
+
+		if (e->d_name[0] == '.')
+			continue;
+
+		char *entry_path = path_join(path, e->d_name);
+		char *entry_name = path_join(name, e->d_name);
+
+		if (stat(entry_path, &st) == -1)
+			pr_fatal_errno(entry_path);
+
+		if (S_ISDIR(st.st_mode))
+			file_list_directory(list, count, dir, entry_name);
+		else if (S_ISREG(st.st_mode) && sndh_extension(e->d_name)) {
+			file_list_add(list, count, entry_path, entry_name, 0);
+			continue;
+		}
+
+		free(entry_name);
+		free(entry_path);
+	}
+
+	if (closedir(d) == -1)
+		pr_fatal_errno(path);
+
+	free(path);
+}
+
+static void file_list_manifest(struct batch_file **list, size_t *count,
+	const char *archive, const char *manifest)
+{
+	struct file f = file_read(manifest);
+	struct string_split line;
+	int n = 1;
+
+	if (!file_valid(f))
+		pr_fatal_errno(manifest);
+
+	for_each_string_split (line, f.data, "\n") {
+		if (line.sep) {
+			n++;
+			continue;
+		}
+
+		char *s = xstrndup(line.s, line.length);
+		int track_count, offset;
+
+		if (!s[0] || s[0] == '#') {
+			free(s);
+			continue;
+		}
+
+		if (sscanf(s, "%d %n", &track_count, &offset) != 1 ||
+		    track_count < 0 || !s[offset])
+			pr_fatal_error("%s:%d: malformed line\n", manifest, n);
+
+		file_list_add(list, count, path_join(archive, &s[offset]),
+			xstrdup(&s[offset]), track_count);
+
+		free(s);
+	}
+
+	file_free(f);
+}
+
+static int file_list_compare(const void *a, const void *b)
+{
+	const struct batch_file *f = a;
+	const struct batch_file *g = b;
+
+	return strcmp(f->name, g->name);
+}
+
+static void queue_init(struct batch_queue *queue)
+{
+	*queue = (struct batch_queue) { };
+
+	pthread_mutex_init(&queue->lock, NULL);
+}
+
+static void queue_free(struct batch_queue *queue)
+{
+	pthread_mutex_destroy(&queue->lock);
+
+	free(queue->task);
+}
+
+static void queue_push(struct batch_queue *queue, struct batch_task task)
+{
+	pthread_mutex_lock(&queue->lock);
+
+	if (queue->tail == queue->capacity) {
+		const size_t n = queue->tail - queue->head;
+
+		memmove(&queue->task[0], &queue->task[queue->head],
+			n * sizeof(*queue->task));
+		queue->head = 0;
+		queue->tail = n;
+
+		if (queue->tail == queue->capacity) {
+			queue->capacity = max_t(size_t, 64, 2 * queue->capacity);
+			queue->task = xrealloc(queue->task,
+				queue->capacity * sizeof(*queue->task));
+		}
+	}
+
+	queue->task[queue->tail++] = task;
+
+	pthread_mutex_unlock(&queue->lock);
+}
+
+/* The owner takes the most recently pushed task, for locality. */
+static bool queue_pop(struct batch_queue *queue, struct batch_task *task)
+{
+	bool popped = false;
+
+	pthread_mutex_lock(&queue->lock);
+
+	if (queue->head < queue->tail) {
+		*task = queue->task[--queue->tail];
+		popped = true;
+	}
+
+	pthread_mutex_unlock(&queue->lock);
+
+	return popped;
+}
+
+/* Thieves take the least recently pushed task, likely the largest. */
+static bool queue_steal(struct batch_queue *queue, struct batch_task *task)
+{
+	bool stolen = false;
+
+	pthread_mutex_lock(&queue->lock);
+
+	if (queue->head < queue->tail) {
+		*task = queue->task[queue->head++];
+		stolen = true;
+	}
+
+	pthread_mutex_unlock(&queue->lock);
+
+	return stolen;
+}
+
+static void batch_push(struct batch_worker *worker, struct batch_task task)
+{
+	struct batch *batch = worker->batch;
+
+	pthread_mutex_lock(&batch->lock);
+	batch->pending++;
+	pthread_mutex_unlock(&batch->lock);
+
+	queue_push(&worker->queue, task);
+
+	pthread_mutex_lock(&batch->lock);
+	batch->generation++;
+	pthread_cond_broadcast(&batch->cond);
+	pthread_mutex_unlock(&batch->lock);
+}
+
+static void batch_done(struct batch *batch, bool ok)
+{
+	pthread_mutex_lock(&batch->lock);
+
+	if (ok)
+		batch->ok_count++;
+	else
+		batch->fail_count++;
+
+	if (!--batch->pending)
+		pthread_cond_broadcast(&batch->cond);
+
+	pthread_mutex_unlock(&batch->lock);
+}
+
+static bool batch_take(struct batch_worker *worker, struct batch_task *task)
+{
+	struct batch *batch = worker->batch;
+
+	if (queue_pop(&worker->queue, task))
+		return true;
+
+	for (size_t i = 1; i < batch->worker_count; i++) {
+		struct batch_worker *victim = &batch->worker[
+			(worker->index + i) % batch->worker_count];
+
+		if (queue_steal(&victim->queue, task))
+			return true;
+	}
+
+	return false;
+}
+
+static void batch_report(const struct batch_file *bf, int track, bool ok,
+	uint64_t elapsed, double duration)
+{
+	flockfile(stdout);
+	printf("track %s %.3f %.3f %d %s\n", ok ? "ok" : "fail",
+		elapsed / 1e9, duration, track, bf->name);
+	fflush(stdout);
+	funlockfile(stdout);
+}
+
+static void file_release(struct batch *batch, struct batch_file *bf)
+{
+	pthread_mutex_lock(&batch->lock);
+	const bool last = !--bf->refs;
+	pthread_mutex_unlock(&batch->lock);
+
+	if (last) {
+		file_free(bf->file);
+		bf->file = (struct file) { };
+	}
+}
+
+static bool mkdir_parents(const char *path)
+{
+	char *p = xstrdup(path);
+	bool ok = true;
+
+	for (char *s = strchr(p + 1, '/'); s && ok; s = strchr(s + 1, '/')) {
+		*s = '\0';
+		ok = mkdir(p, 0755) == 0 || errno == EEXIST;
+		*s = '/';
+	}
+
+	free(p);
+
+	return ok;
+}
+
+static char *output_path(const struct batch_options *options,
+	const struct batch_file *bf, int track)
+{
+	const size_t length = strlen(bf->name) -
+		(sndh_extension(bf->name) ? 5 : 0);
+	struct strbuf sb = { };
+
+	if (!sbprintf(&sb, "%s/%.*s-%d.%s", options->output,
+			(int)length, bf->name, track,
+			options->raw ? "raw" : "wav"))
+		pr_fatal_errno("output_path");
+
+	return sb.s;
+}
+
+static double track_loop(const struct batch_options *options,
+	const struct batch_file *bf, int track)
+{
+	struct psgplay_loop loop;
+
+	if (!options->detect_loop || psgplay_loop(&loop,
+			bf->file.data, bf->file.size, track,
+			options->length) != 1)
+		return 0;
+
+	return loop.end ? loop.start : loop.start + loop.length;
+}
+
+static double track_duration(const struct batch_options *options,
+	const struct batch_file *bf, int track)
+{
+	float duration;
+
+	if (!sndh_tag_subtune_time(&duration, track,
+			bf->file.data, bf->file.size) || duration <= 0) {
+		const double loop = track_loop(options, bf, track);
+
+		return loop > 0 ? loop : options->length;
+	}
+
+	return duration;
+}
+
+static bool render_cached(const struct batch_options *options,
+	const char *key, const struct audio_writer *output, void *output_arg)
+{
+	struct cache_reader *reader = cache_reader_open(&options->cache, key,
+		sizeof(struct psgplay_stereo));
+
+	if (!reader)
+		return false;
+
+	for (;;) {
+		struct psgplay_stereo buffer[4096];
+
+		const size_t n = cache_read(reader, buffer, ARRAY_SIZE(buffer));
+
+		/* Write failures are reported when the output is closed. */
+		if (!n || output->write(buffer, n, output_arg) < n)
+			break;
+	}
+
+	cache_reader_close(reader);
+
+	return true;
+}
+
+static bool render_track(const struct batch_options *options,
+	const struct batch_file *bf, int track, double duration)
+{
+	const size_t sample_length = duration * options->frequency + 0.5;
+	const struct audio_writer *output = options->raw ?
+		&raw_writer_nonfatal : &wave_writer_nonfatal;
+	char *path = output_path(options, bf, track);
+	char *key = options->cache.dir ? cache_key(bf->file.data,
+		bf->file.size, track, options->frequency, "empiric",
+		duration, options->silence) : NULL;
+	struct cache_writer *writer = NULL;
+	struct psgplay *pp = NULL;
+	void *output_arg = NULL;
+	bool ok = false;
+
+	if (!mkdir_parents(path)) {
+		pr_errno(path);
+		goto out;
+	}
+
+	output_arg = output->open(path, options->frequency, false,
+		sample_length);
+	if (!output_arg)
+		goto out;
+
+	if (key && render_cached(options, key, output, output_arg)) {
+		ok = true;
+		goto out;
+	}
+
+	pp = psgplay_init(bf->file.data, bf->file.size,
+		track, options->frequency);
+	if (!pp) {
+		pr_error("%s: track %d: failed to init PSG play\n",
+			bf->name, track);
+		goto out;
+	}
+
+	psgplay_stop_at_time(pp, duration);
+	psgplay_stop_at_silence(pp, options->silence);
+
+	if (key)
+		writer = cache_writer_open(&options->cache, key,
+			sizeof(struct psgplay_stereo));
+
+	for (;;) {
+		struct psgplay_stereo buffer[4096];
+
+		const ssize_t r = psgplay_read_stereo(
+			pp, buffer, ARRAY_SIZE(buffer));
+
+		if (r < 0) {
+			pr_error("%s: track %d: failed to read PSG play\n",
+				bf->name, track);
+			goto out;
+		} else if (!r)
+			break;
+
+		if (writer)
+			cache_write(writer, buffer, r);
+
+		if (output->write(buffer, r, output_arg) < r)
+			goto out;
+	}
+
+	ok = true;
+
+out:
+	cache_writer_close(writer, ok);
+	if (output_arg && !output->close(output_arg))
+		ok = false;
+	psgplay_free(pp);
+	free(path);
+	free(key);
+
+	return ok;
+}
+
+static void batch_track(struct batch_worker *worker,
+	struct batch_file *bf, int track)
+{
+	const uint64_t start = clock_ns();
+	const double duration =
+		track_duration(worker->batch->options, bf, track);
+	const bool ok =
+		render_track(worker->batch->options, bf, track, duration);
+
+	batch_report(bf, track, ok, clock_ns() - start, ok ? duration : 0);
+
+	file_release(worker->batch, bf);
+
+	batch_done(worker->batch, ok);
+}
+
+/*
+ * The file is read once and shared by its tracks. The tracks other than
+ * the first are pushed to the worker's own queue, where they can be stolen
+ * by other workers.
+ */
+static void batch_file(struct batch_worker *worker, struct batch_file *bf)
+{
+	const uint64_t start = clock_ns();
+	int track_count = bf->track_count;
+
+	bf->file = sndh_read_file(bf->path);
+
+	if (!file_valid(bf->file)) {
+		pr_errno(bf->path);
+
+		batch_report(bf, 0, false, clock_ns() - start, 0);
+		batch_done(worker->batch, false);
+		return;
+	}
+
+	if (!track_count &&
+	    !sndh_tag_subtune_count(&track_count,
+			bf->file.data, bf->file.size))
+		track_count = 1;
+
+	bf->refs = max(track_count, 1);
+
+	for (int track = track_count; track > 1; track--)
+		batch_push(worker, (struct batch_task) {
+			.file = bf,
+			.track = track,
+		});
+
+	batch_track(worker, bf, 1);
+}
+
+static void *batch_work(void *arg)
+{
+	struct batch_worker *worker = arg;
+	struct batch *batch = worker->batch;
+
+	for (;;) {
+		struct batch_task task;
+
+		pthread_mutex_lock(&batch->lock);
+		const uint64_t generation = batch->generation;
+		pthread_mutex_unlock(&batch->lock);
+
+		if (batch_take(worker, &task)) {
+			if (task.track)
+				batch_track(worker, task.file, task.track);
+			else
+				batch_file(worker, task.file);
+			continue;
+		}
+
+		pthread_mutex_lock(&batch->lock);
+		while (batch->pending && batch->generation == generation)
+			pthread_cond_wait(&batch->cond, &batch->lock);
+		const bool done = !batch->pending;
+		pthread_mutex_unlock(&batch->lock);
+
+		if (done)
+			break;
+	}
+
+	return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+	const struct batch_options options = parse_options(argc, argv);
+	const uint64_t start = clock_ns();
+	struct batch_file *list = NULL;
+	size_t count = 0;
+
+	for (int i = optind; i < argc; i++) {
+		struct stat st;
+
+		if (stat(argv[i], &st) == -1)
+			pr_fatal_errno(argv[i]);
+
+		if (S_ISDIR(st.st_mode))
+			file_list_directory(&list, &count, argv[i], "");
+		else if (sndh_extension(argv[i]))
+			file_list_add(&list, &count, xstrdup(argv[i]),
+				xstrdup(file_basename(argv[i])), 0);
+		else
+			file_list_manifest(&list, &count,
+				options.archive, argv[i]);
+	}
+
+	qsort(list, count, sizeof(*list), file_list_compare);
+
+	struct batch batch = {
+		.options = &options,
+		.worker_count = options.jobs,
+		.worker = xmalloc(options.jobs * sizeof(struct batch_worker)),
+	};
+
+	pthread_mutex_init(&batch.lock, NULL);
+	pthread_cond_init(&batch.cond, NULL);
+
+	for (size_t i = 0; i < batch.worker_count; i++) {
+		batch.worker[i] = (struct batch_worker) {
+			.batch = &batch,
+			.index = i,
+		};
+		queue_init(&batch.worker[i].queue);
+	}
+
+	/* Files are dealt to the workers, which steal when idle. */
+	for (size_t i = 0; i < count; i++)
+		batch_push(&batch.worker[i % batch.worker_count],
+			(struct batch_task) { .file = &list[i] });
+
+	for (size_t i = 0; i < batch.worker_count; i++) {
+		const int r = pthread_create(&batch.worker[i].thread, NULL,
+			batch_work, &batch.worker[i]);
+
+		if (r) {
+			errno = r;
+			pr_fatal_errno("pthread_create");
+		}
+	}
+
+	for (size_t i = 0; i < batch.worker_count; i++)
+		pthread_join(batch.worker[i].thread, NULL);
+
+	printf("batch %zu %zu %.3f\n", batch.ok_count, batch.fail_count,
+		(clock_ns() - start) / 1e9);
+
+	for (size_t i = 0; i < batch.worker_count; i++)
+		queue_free(&batch.worker[i].queue);
+	free(batch.worker);
+
+	pthread_cond_destroy(&batch.cond);
+	pthread_mutex_destroy(&batch.lock);
+
+	for (size_t i = 0; i < count; i++) {
+		free(list[i].path);
+		free(list[i].name);
+	}
+	free(list);
+
+	return batch.fail_count ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,492 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (C) 2026 Fredrik Noring
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "internal/compare.h"
+#include "internal/print.h"
+
+#include "psgplay/version.h"
+
+#include "system/unix/cache.h"
+#include "system/unix/memory.h"
+#include "system/unix/string.h"
+
+#define CACHE_MAGIC "PSGC"
+#define CACHE_EXTENSION ".psgc"
+#define CACHE_BYTE_ORDER 0x01020304	/* Entries are in host byte order */
+
+/**
+ * struct cache_header - cache entry header
+ * @magic: %CACHE_MAGIC
+ * @byte_order: %CACHE_BYTE_ORDER, in host byte order
+ * @record_size: size in bytes of each sample
+ * @key_length: length in bytes of key, that follows the header
+ *
+ * The key is followed by blocks of samples, each beginning with an unsigned
+ * LEB128 number n. If n is odd, the block is a run of n/2 repetitions of
+ * the single sample that follows. If n is even, the block is n/2 samples
+ * that follow literally.
+ */
+struct cache_header {
+	char magic[4];
+	uint32_t byte_order;
+	uint32_t record_size;
+	uint32_t key_length;
+};
+
+#define CACHE_LITERAL_MAX 4096	/* Maximum samples in a literal block */
+
+struct cache_reader {
+	const uint8_t *map;
+	size_t size;
+	size_t offset;
+
+	size_t record_size;
+	const uint8_t *record;
+	uint64_t count;
+	bool run;
+};
+
+struct cache_writer {
+	const struct cache *cache;
+	char *path;
+	char *tmp;
+	FILE *file;
+
+	size_t record_size;
+	uint8_t *record;
+	uint64_t run;
+
+	uint8_t *literal;
+	size_t literal_count;
+};
+
+static uint64_t fnv1a(uint64_t h, const void *data, size_t size)
+{
+	const uint8_t *b = data;
+
+	for (size_t i = 0; i < size; i++)
+		h = (h ^ b[i]) * 0x100000001b3;
+
+	return h;
+}
+
+static uint64_t hash(const void *data, size_t size)
+{
+	return fnv1a(0xcbf29ce484222325, data, size);
+}
+
+uint64_t cache_size_option(const char *s)
+{
+	char *e;
+
+	errno = 0;
+	const unsigned long long size = strtoull(s, &e, 10);
+
+	if (e == s || *e != '\0' || s[0] == '-' || errno ||
+	    size > UINT64_MAX / (1024 * 1024))
+		pr_fatal_error("invalid cache size: %s\n", s);
+
+	return (uint64_t)size * 1024 * 1024;
+}
+
+char *cache_key(const void *data, size_t size, int track, int frequency,
+	const char *mix, float stop, float silence)
+{
+	struct strbuf sb = { };
+
+	/*
+	 * The version is part of the key, since entries rendered by other
+	 * versions of the emulator may differ.
+	 */
+	if (!sbprintf(&sb, "psgplay %s sndh %016llx %zu track %d %s %d "
+			"mix %s stop %.9g", psgplay_version(),
+			(unsigned long long)hash(data, size), size, track,
+			frequency ? "stereo" : "digital", frequency,
+			mix ? mix : "none", stop))
+		pr_fatal_errno("cache_key");
+
+	/* Keys without silence detection are kept as they were. */
+	if (silence > 0 && !sbprintf(&sb, " silence %.9g", silence))
+		pr_fatal_errno("cache_key");
+
+	return sb.s;
+}
+
+static char *entry_path(const struct cache *cache, const char *key)
+{
+	struct strbuf sb = { };
+
+	if (!sbprintf(&sb, "%s/%016llx" CACHE_EXTENSION, cache->dir,
+			(unsigned long long)hash(key, strlen(key))))
+		pr_fatal_errno("entry_path");
+
+	return sb.s;
+}
+
+static bool entry_valid(const struct cache_reader *reader, const char *key,
+	size_t record_size)
+{
+	const size_t key_length = strlen(key);
+	struct cache_header header;
+
+	if (reader->size < sizeof(header))
+		return false;
+
+	memcpy(&header, reader->map, sizeof(header));
+
+	return memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) == 0 &&
+	       header.byte_order == CACHE_BYTE_ORDER &&
+	       header.record_size == record_size &&
+	       header.key_length == key_length &&
+	       sizeof(header) + key_length <= reader->size &&
+	       memcmp(&reader->map[sizeof(header)], key, key_length) == 0;
+}
+
+struct cache_reader *cache_reader_open(const struct cache *cache,
+	const char *key, size_t record_size)
+{
+	char *path = entry_path(cache, key);
+	const int fd = open(path, O_RDONLY);
+	struct cache_reader *reader = NULL;
+	struct stat st;
+
+	if (fd < 0)
+		goto out;
+
+	if (fstat(fd, &st) == -1 || !st.st_size)
+		goto out_close;
+
+	void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED)
+		goto out_close;
+
+	reader = zalloc(sizeof(*reader));
+	*reader = (struct cache_reader) {
+		.map = map,
+		.size = st.st_size,
+		.offset = sizeof(struct cache_header) + strlen(key),
+		.record_size = record_size,
+	};
+
+	if (!entry_valid(reader, key, record_size)) {
+		cache_reader_close(reader);
+		reader = NULL;
+		goto out_close;
+	}
+
+	madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+	/* The modification time orders entries by least recent use. */
+	futimens(fd, NULL);
+
+out_close:
+	close(fd);
+out:
+	free(path);
+
+	return reader;
+}
+
+static bool read_leb128(struct cache_reader *reader, uint64_t *value)
+{
+	*value = 0;
+
+	for (int shift = 0; reader->offset < reader->size && shift < 64;
+			shift += 7) {
+		const uint8_t b = reader->map[reader->offset++];
+
+		*value |= (uint64_t)(b & 0x7f) << shift;
+
+		if (!(b & 0x80))
+			return true;
+	}
+
+	return false;
+}
+
+static bool read_block(struct cache_reader *reader)
+{
+	uint64_t n;
+
+	if (!read_leb128(reader, &n))
+		return false;
+
+	const bool run = n & 1;
+	const uint64_t count = n >> 1;
+	const uint64_t size = (run ? 1 : count) * reader->record_size;
+
+	if (!count || reader->size - reader->offset < size)
+		return false;
+
+	reader->record = &reader->map[reader->offset];
+	reader->offset += size;
+	reader->count = count;
+	reader->run = run;
+
+	return true;
+}
+
+size_t cache_read(struct cache_reader *reader, void *buffer, size_t count)
+{
+	uint8_t *b = buffer;
+	size_t i = 0;
+
+	while (i < count) {
+		if (!reader->count && !read_block(reader))
+			break;
+
+		const size_t n = min_t(uint64_t, reader->count, count - i);
+
+		if (b && reader->run)
+			for (size_t k = 0; k < n; k++)
+				memcpy(&b[(i + k) * reader->record_size],
+					reader->record, reader->record_size);
+		else if (b)
+			memcpy(&b[i * reader->record_size], reader->record,
+				n * reader->record_size);
+
+		if (!reader->run)
+			reader->record += n * reader->record_size;
+		reader->count -= n;
+		i += n;
+	}
+
+	return i;
+}
+
+void cache_reader_close(struct cache_reader *reader)
+{
+	if (!reader)
+		return;
+
+	munmap((void *)reader->map, reader->size);
+	free(reader);
+}
+
+struct cache_writer *cache_writer_open(const struct cache *cache,
+	const char *key, size_t record_size)
+{
+	const struct cache_header header = {
+		.magic = CACHE_MAGIC,
+		.byte_order = CACHE_BYTE_ORDER,
+		.record_size = record_size,
+		.key_length = strlen(key),
+	};
+	struct strbuf sb = { };
+
+	if (mkdir(cache->dir, 0755) == -1 && errno != EEXIST) {
+		pr_errno(cache->dir);
+		return NULL;
+	}
+
+	if (!sbprintf(&sb, "%s/.tmp-XXXXXX", cache->dir))
+		pr_fatal_errno("cache_writer_open");
+
+	const int fd = mkstemp(sb.s);
+	if (fd < 0) {
+		pr_errno(sb.s);
+		sbfree(&sb);
+		return NULL;
+	}
+
+	struct cache_writer *writer = zalloc(sizeof(*writer));
+	*writer = (struct cache_writer) {
+		.cache = cache,
+		.path = entry_path(cache, key),
+		.tmp = sb.s,
+		.file = fdopen(fd, "w"),
+		.record_size = record_size,
+		.record = xmalloc(record_size),
+		.literal = xmalloc(CACHE_LITERAL_MAX * record_size),
+	};
+
+	if (!writer->file) {
+		close(fd);
+		cache_writer_close(writer, false);
+		return NULL;
+	}
+
+	fwrite(&header, sizeof(header), 1, writer->file);
+	fwrite(key, header.key_length, 1, writer->file);
+
+	return writer;
+}
+
+static void write_leb128(struct cache_writer *writer, uint64_t value)
+{
+	for (; value >= 0x80; value >>= 7)
+		putc(0x80 | (value & 0x7f), writer->file);
+
+	putc(value, writer->file);
+}
+
+static void write_literal(struct cache_writer *writer)
+{
+	if (!writer->literal_count)
+		return;
+
+	write_leb128(writer, writer->literal_count << 1);
+	fwrite(writer->literal, writer->record_size,
+		writer->literal_count, writer->file);
+
+	writer->literal_count = 0;
+}
+
+/* Single samples are gathered into literal blocks. */
+static void write_run(struct cache_writer *writer)
+{
+	if (writer->run == 1) {
+		memcpy(&writer->literal[writer->literal_count++ *
+			writer->record_size], writer->record,
+			writer->record_size);
+
+		if (writer->literal_count == CACHE_LITERAL_MAX)
+			write_literal(writer);
+	} else if (writer->run) {
+		write_literal(writer);
+
+		write_leb128(writer, (writer->run << 1) | 1);
+		fwrite(writer->record, writer->record_size, 1, writer->file);
+	}
+
+	writer->run = 0;
+}
+
+void cache_write(struct cache_writer *writer,
+	const void *buffer, size_t count)
+{
+	const uint8_t *b = buffer;
+
+	for (size_t i = 0; i < count; i++) {
+		const uint8_t *record = &b[i * writer->record_size];
+
+		if (writer->run &&
+		    memcmp(writer->record, record, writer->record_size) == 0) {
+			writer->run++;
+			continue;
+		}
+
+		write_run(writer);
+
+		memcpy(writer->record, record, writer->record_size);
+		writer->run = 1;
+	}
+}
+
+struct cache_entry {
+	char *path;
+	off_t size;
+	time_t mtime;
+};
+
+static int cache_entry_compare(const void *a, const void *b)
+{
+	const struct cache_entry *x = a;
+	const struct cache_entry *y = b;
+
+	return x->mtime < y->mtime ? -1 : x->mtime > y->mtime ? 1 : 0;
+}
+
+static bool cache_extension(const char *name)
+{
+	const size_t length = strlen(name);
+	const size_t n = strlen(CACHE_EXTENSION);
+
+	return length > n && strcmp(&name[length - n], CACHE_EXTENSION) == 0;
+}
+
+/* Remove least recently used entries until the cache is small enough. */
+static void cache_evict(const struct cache *cache)
+{
+	struct cache_entry *entry = NULL;
+	size_t count = 0;
+	uint64_t total = 0;
+	DIR *dir = opendir(cache->dir);
+
+	if (!dir)
+		return;
+
+	for (struct dirent *de = readdir(dir); de; de = readdir(dir)) {
+		struct strbuf sb = { };
+		struct stat st;
+
+		if (!cache_extension(de->d_name))
+			continue;
+
+		if (!sbprintf(&sb, "%s/%s", cache->dir, de->d_name))
+			pr_fatal_errno("cache_evict");
+
+		if (stat(sb.s, &st) == -1 || !S_ISREG(st.st_mode)) {
+			sbfree(&sb);
+			continue;
+		}
+
+		entry = xrealloc(entry, (count + 1) * sizeof(*entry));
+		entry[count++] = (struct cache_entry) {
+			.path = sb.s,
+			.size = st.st_size,
+			.mtime = st.st_mtime,
+		};
+		total += st.st_size;
+	}
+
+	closedir(dir);
+
+	if (total > cache->size_limit)
+		qsort(entry, count, sizeof(*entry), cache_entry_compare);
+
+	/* Entries may be removed concurrently by other writers. */
+	for (size_t i = 0; i < count && total > cache->size_limit; i++)
+		if (unlink(entry[i].path) == 0 || errno == ENOENT)
+			total -= entry[i].size;
+
+	for (size_t i = 0; i < count; i++)
+		free(entry[i].path);
+	free(entry);
+}
+
+void cache_writer_close(struct cache_writer *writer, bool commit)
+{
+	if (!writer)
+		return;
+
+	if (writer->file) {
+		write_run(writer);
+		write_literal(writer);
+
+		if (ferror(writer->file))
+			commit = false;
+		if (fclose(writer->file) == EOF)
+			commit = false;
+	}
+
+	if (commit && rename(writer->tmp, writer->path) == -1) {
+		pr_errno(writer->path);
+		commit = false;
+	}
+
+	if (!commit)
+		unlink(writer->tmp);
+	else
+		cache_evict(writer->cache);
+
+	free(writer->literal);
+	free(writer->record);
+	free(writer->path);
+	free(writer->tmp);
+	free(writer);
+}
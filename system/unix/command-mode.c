@@ -6,6 +6,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
@@ -16,16 +17,22 @@
 #include "internal/compare.h"
 #include "internal/print.h"
 
+#include "psgplay/digital.h"
+#include "psgplay/loop.h"
 #include "psgplay/psgplay.h"
 #include "psgplay/sndh.h"
+#include "psgplay/ym.h"
 
 #include "audio/writer.h"
 
+#include "system/unix/cache.h"
 #include "system/unix/file.h"
 #include "system/unix/memory.h"
 #include "system/unix/option.h"
 #include "system/unix/command-mode.h"
 
+#define LOOP_LIMIT (10 * 60)	/* Analyse at most 10 minutes for loops */
+
 struct replay_state {
 	ssize_t sample_start;
 	ssize_t sample_stop;
@@ -52,20 +59,39 @@ static float parse_start(const char *s)
 	return !s ? 0 : parse_time(s);
 }
 
-static float parse_stop_auto(int track, struct file file)
+static float parse_stop_loop(int track, struct file file)
+{
+	struct psgplay_loop loop;
+	const int r = psgplay_loop(&loop,
+		file.data, file.size, track, LOOP_LIMIT);
+
+	if (r < 0)
+		pr_fatal_errno(file.path);
+
+	return !r      ? OPTION_TIME_UNDEFINED :
+	       loop.end ? loop.start : loop.start + loop.length;
+}
+
+static float parse_stop_auto(int track, struct file file, bool loop)
 {
 	float duration;
 
 	if (!sndh_tag_subtune_time(&duration, track, file.data, file.size))
-		return OPTION_TIME_UNDEFINED;
+		return loop ? parse_stop_loop(track, file) :
+			OPTION_TIME_UNDEFINED;
 
 	return duration > 0 ? duration : OPTION_STOP_NEVER;
 }
 
-static float parse_stop(const char *s, int track, struct file file)
+/*
+ * An explicit --stop=auto detects loops if the track has no known
+ * duration, which takes some time since the track must be emulated.
+ */
+static float parse_stop(const char *s, int track, struct file file,
+	bool loop)
 {
 	return !s                      ? OPTION_TIME_UNDEFINED :
-	       strcmp(s, "auto") == 0  ? parse_stop_auto(track, file) :
+	       strcmp(s, "auto") == 0  ? parse_stop_auto(track, file, loop) :
 	       strcmp(s, "never") == 0 ? OPTION_STOP_NEVER : parse_time(s);
 }
 
@@ -74,6 +100,11 @@ static float parse_length(const char *s, float start)
 	return !s ? OPTION_TIME_UNDEFINED : start + parse_time(s);
 }
 
+static float parse_silence(const char *s)
+{
+	return !s ? 0 : parse_time(s);
+}
+
 static float stop_or_length(float stop, float length)
 {
 	return   stop == OPTION_TIME_UNDEFINED ? length :
@@ -81,27 +112,54 @@ static float stop_or_length(float stop, float length)
 		 stop == OPTION_STOP_NEVER     ? length : min(stop, length);
 }
 
-void command_replay(const struct options *options, struct file file,
-	const struct audio_writer *output)
+static float replay_stop(const struct options *options, struct file file,
+	float time_start)
 {
 	const char *auto_stop = options->stop ? options->stop :
 		!options->stop && !options->length ? "auto" : NULL;
-	const float time_start = parse_start(options->start);
-	const ssize_t sample_start = time_start * options->frequency;
 	const float length = parse_length(options->length, time_start);
-	const float time_stop = stop_or_length(
-		parse_stop(auto_stop, options->track, file), length);
-	const ssize_t sample_stop = time_stop >= 0 ?
-		time_stop * options->frequency + 0.5 : -1;
-	const ssize_t sample_length = sample_stop >= 0 ?
-		sample_stop - sample_start : -1;
 
-	void *output_arg = output->open(
-		options->output, options->frequency, false,
-		sample_length > 0 ? sample_length : 0);
+	return stop_or_length(parse_stop(auto_stop, options->track, file,
+		options->stop != NULL), length);
+}
+
+static bool replay_cached(const struct cache *cache, const char *key,
+	ssize_t sample_start, const struct audio_writer *output,
+	void *output_arg)
+{
+	struct cache_reader *reader = cache_reader_open(cache, key,
+		sizeof(struct psgplay_stereo));
+
+	if (!reader)
+		return false;
+
+	if (sample_start > 0)
+		cache_read(reader, NULL, sample_start);
+
+	for (;;) {
+		struct psgplay_stereo buffer[4096];
+
+		const size_t n = cache_read(reader, buffer, ARRAY_SIZE(buffer));
+
+		if (!n || output->write(buffer, n, output_arg) < n)
+			break;
+	}
+
+	cache_reader_close(reader);
+
+	return true;
+}
+
+static void replay_render(const struct options *options, struct file file,
+	const struct cache *cache, const char *key,
+	float time_stop, ssize_t sample_start,
+	const struct audio_writer *output, void *output_arg)
+{
+	struct cache_writer *writer = key ? cache_writer_open(cache, key,
+		sizeof(struct psgplay_stereo)) : NULL;
 	struct psgplay *pp = psgplay_init(file.data, file.size,
 		options->track, options->frequency);
-	ssize_t sample_count = 0;
+	bool complete = false;
 
 	if (!pp)
 		pr_fatal_error("%s: failed to init PSG play\n", progname);
@@ -112,32 +170,199 @@ void command_replay(const struct options *options, struct file file,
 	if (time_stop >= 0)
 		psgplay_stop_at_time(pp, time_stop);
 
-	for (;;) {
+	psgplay_stop_at_silence(pp, parse_silence(options->silence));
+
+	/* Cache entries begin with the first sample, so none are skipped. */
+	if (sample_start > 0 && !writer &&
+	    psgplay_skip(pp, sample_start) < 0)
+		pr_fatal_error("%s: failed to skip PSG play\n", progname);
+
+	for (ssize_t i = writer ? 0 : sample_start; ; ) {
 		struct psgplay_stereo buffer[256];
 
-		const ssize_t r = psgplay_read_stereo(
-			pp, buffer, ARRAY_SIZE(buffer));
+		const ssize_t r = psgplay_read_stereo(pp, buffer,
+			i < sample_start ? min_t(ssize_t,
+				sample_start - i, ARRAY_SIZE(buffer)) :
+				ARRAY_SIZE(buffer));
 
-		if (!r)
+		if (r < 0)
+			pr_fatal_error("%s: failed to read PSG play\n", progname);
+		else if (!r) {
+			complete = true;
 			break;
+		}
 
-		for (size_t i = 0; i < r; i++) {
-			if (sample_count < sample_start) {
-				sample_count++;
-				continue;
-			}
-
-			sample_count++;
+		if (writer)
+			cache_write(writer, buffer, r);
 
-			if (!output->sample(
-					buffer[i].left,
-					buffer[i].right, output_arg))
-				goto out;
-		}
+		if (i < sample_start)
+			i += r;
+		else if (output->write(buffer, r, output_arg) < r)
+			break;
 	}
-out:
+
+	cache_writer_close(writer, complete);
 
 	psgplay_free(pp);
+}
+
+void command_replay(const struct options *options, struct file file,
+	const struct audio_writer *output)
+{
+	const float time_start = parse_start(options->start);
+	const ssize_t sample_start = time_start * options->frequency;
+	const float time_stop = replay_stop(options, file, time_start);
+	const ssize_t sample_stop = time_stop >= 0 ?
+		time_stop * options->frequency + 0.5 : -1;
+	const ssize_t sample_length = sample_stop >= 0 ?
+		sample_stop - sample_start : -1;
+	const struct cache cache = {
+		.dir = options->cache,
+		.size_limit = options->cache_size,
+	};
+	char *mix = options->cache && time_stop >= 0 ? psg_mix_key() : NULL;
+	char *key = mix ? cache_key(file.data, file.size, options->track,
+		options->frequency, mix, time_stop,
+		parse_silence(options->silence)) : NULL;
+
+	void *output_arg = output->open(
+		options->output, options->frequency, false,
+		sample_length > 0 ? sample_length : 0);
+
+	if (!key || !replay_cached(&cache, key, sample_start,
+			output, output_arg))
+		replay_render(options, file, &cache, key, time_stop,
+			sample_start, output, output_arg);
 
 	output->close(output_arg);
+
+	free(key);
+	free(mix);
+}
+
+struct register_buffer {
+	size_t count;
+	size_t capacity;
+	struct psgplay_psg_register *reg;
+};
+
+static void register_buffer_capture(struct psgplay *pp,
+	const struct psgplay_psg_register *reg, void *arg)
+{
+	struct register_buffer *rb = arg;
+
+	if (rb->capacity <= rb->count) {
+		rb->capacity = rb->capacity + max_t(size_t, rb->capacity, 4096);
+		rb->reg = xrealloc(rb->reg, rb->capacity * sizeof(*rb->reg));
+	}
+
+	rb->reg[rb->count++] = *reg;
+}
+
+static int export_frame_rate(struct file file)
+{
+	struct sndh_timer timer;
+
+	if (!sndh_tag_timer(&timer, file.data, file.size) ||
+	    timer.frequency < 1 || 0xffff < timer.frequency)
+		return 50;
+
+	return timer.frequency;
+}
+
+static void *export_ym(size_t *size, const struct options *options,
+	struct file file, uint64_t start, float length,
+	const struct register_buffer *rb)
+{
+	const int frame_rate = export_frame_rate(file);
+	char title[256], author[256], comment[256];
+
+	if (!sndh_tag_title(title, sizeof(title), file.data, file.size))
+		title[0] = '\0';
+	if (!sndh_tag_composer(author, sizeof(author), file.data, file.size))
+		author[0] = '\0';
+	snprintf(comment, sizeof(comment), "%s track %d",
+		file_basename(file.path), options->track);
+
+	const struct psgplay_ym ym = {
+		.version = strcmp(options->export_format, "ym5") == 0 ? 5 : 6,
+		.frame_rate = frame_rate,
+		.frame_count = max(1.0f, length * frame_rate + 0.5f),
+		.start = start,
+		.title = title,
+		.author = author,
+		.comment = comment,
+	};
+	const ssize_t n = psgplay_ym(NULL, 0, &ym, rb->reg, rb->count);
+	if (n < 0)
+		pr_fatal_errno(options->export_ym);
+
+	void *buf = xmalloc(n);
+	psgplay_ym(buf, n, &ym, rb->reg, rb->count);
+	*size = n;
+
+	return buf;
+}
+
+static void *export_log(size_t *size, uint64_t start,
+	const struct register_buffer *rb)
+{
+	const size_t n = psgplay_psg_register_log(NULL, 0,
+		start, rb->reg, rb->count);
+	void *buf = xmalloc(n);
+
+	psgplay_psg_register_log(buf, n, start, rb->reg, rb->count);
+	*size = n;
+
+	return buf;
+}
+
+void command_export(const struct options *options, struct file file)
+{
+	const float time_start = parse_start(options->start);
+	const float time_stop = replay_stop(options, file, time_start);
+	struct register_buffer rb = { };
+
+	if (time_stop < 0)
+		pr_fatal_error("%s: unknown duration, use --stop or --length\n",
+			file.path);
+	if (time_stop <= time_start)
+		pr_fatal_error("%s: nothing to export\n", file.path);
+
+	struct psgplay *pp = psgplay_init(file.data, file.size,
+		options->track, 0);
+
+	if (!pp)
+		pr_fatal_error("%s: failed to init PSG play\n", progname);
+
+	psgplay_psg_register_callback(pp, register_buffer_capture, &rb);
+
+	/* Digital samples are not mixed, which is considerably faster. */
+	psgplay_stop_digital_at_sample(pp,
+		time_stop * (PSGPLAY_PSG_FREQUENCY / 8.0) + 0.5);
+	psgplay_stop_at_silence(pp, parse_silence(options->silence));
+
+	for (;;) {
+		const ssize_t r = psgplay_read_digital(pp, NULL, 65536);
+
+		if (r < 0)
+			pr_fatal_error("%s: failed to read PSG play\n", progname);
+		else if (!r)
+			break;
+	}
+
+	const uint64_t start = psgplay_psg_play_cycle(pp) +
+		(uint64_t)(time_start * PSGPLAY_PSG_FREQUENCY + 0.5);
+	size_t size;
+	void *buf = strcmp(options->export_format, "log") == 0 ?
+		export_log(&size, start, &rb) :
+		export_ym(&size, options, file, start,
+			time_stop - time_start, &rb);
+
+	if (!file_write(options->export_ym, buf, size))
+		pr_fatal_errno(options->export_ym);
+
+	free(buf);
+	free(rb.reg);
+	psgplay_free(pp);
 }
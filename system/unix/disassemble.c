@@ -24,6 +24,7 @@
 
 #include "atari/machine.h"
 #include "atari/mmu.h"
+#include "atari/mmu-trace.h"
 #include "atari/trace.h"
 
 #include "system/unix/disassemble.h"
@@ -705,11 +706,11 @@ static void dasm_mark_text_trace_run(
 			.machine = &pp->machine,
 			.arg = arg,
 		};
-		pp->machine.trace = &options->trace;
+		mmu_trace_mode(&pp->machine, &options->trace);
 
 		psgplay_instruction_callback(pp, insn_cb, &insn_arg);
 
-		psgplay_read_stereo(pp, NULL, sample_count);
+		psgplay_skip(pp, sample_count);
 
 		psgplay_free(pp);
 	}
@@ -21,8 +21,10 @@
 
 #include "audio/alsa-writer.h"
 
+#include "system/unix/cache.h"
 #include "system/unix/file.h"
 #include "system/unix/option.h"
+#include "system/unix/string.h"
 #include "system/unix/tty.h"
 
 static struct options option;
@@ -60,8 +62,12 @@ static void help(FILE *file)
 "    --start=<[mm:]ss.ss>   start playing at the given time\n"
 "    --stop=<[mm:]ss.ss|auto|never>\n"
 "                           stop playing at the given time, or automatically\n"
-"                           if the track has a known duration, or never\n"
+"                           if the track has a known duration or if it can\n"
+"                           be detected to loop or end, or never\n"
 "    --length=<[mm:]ss.ss>  play for the given duration\n"
+"    --silence=<[mm:]ss.ss> stop playing after the given duration of silence,\n"
+"                           when PSG and DMA sound levels are constant and\n"
+"                           no PSG register is changed\n"
 "\n"
 "    -m, --mode=<command|text>\n"
 "                           command or interactive text mode\n"
@@ -85,6 +91,20 @@ static void help(FILE *file)
 "                           play channel C only. Default is 1:1:1. See Notes\n"
 "                           below on combining filters\n"
 "\n"
+"    --cache=<directory>    cache rendered audio in the directory, to replay\n"
+"                           it without emulation in command mode, if the\n"
+"                           stop time is known\n"
+"    --cache-size=<MiB>     remove the least recently used cached audio when\n"
+"                           the cache exceeds the size (default 1024)\n"
+"\n"
+"Export options:\n"
+"\n"
+"    --export-ym=<file>     export PSG register writes to the file and exit;\n"
+"                           the --start, --stop and --length options apply\n"
+"    --export-format=<ym6|ym5|log>\n"
+"                           YM6 (default) or YM5 frames at the SNDH timer\n"
+"                           rate, or a lossless log of timestamped writes\n"
+"\n"
 "Disassembly options:\n"
 "\n"
 "    --disassemble          disassemble SNDH file and exit; may be combined\n"
@@ -97,6 +117,9 @@ static void help(FILE *file)
 "Trace options:\n"
 "\n"
 "    --trace-output=<file>  write trace events to file (default stdout)\n"
+"    --trace-format=<text|binary>\n"
+"                           text (default) or binary records of device\n"
+"                           operations, where binary excludes wch, cpu and reg\n"
 "    --trace=<device>,...   trace device operations of SNDH file and exit:\n"
 #define TRACE_DEVICE_HELP(symbol_, label_, id_) " " #symbol_
 "                          " TRACE_DEVICE(TRACE_DEVICE_HELP) "\n"
@@ -148,6 +171,8 @@ static bool command_mode_only_option(void)
 	       option.start   ||
 	       option.length  ||
 	       option.stop    ||
+	       option.silence ||
+	       option.export_ym ||
 	       file_output();
 }
 
@@ -243,7 +268,7 @@ static struct psgplay_psg_stereo_volume psg_volume_option(const char *s)
 	};
 }
 
-static struct trace_mode trace_option(const char *s)
+static uint32_t trace_option(const char *s)
 {
 	struct string_split dev;
 	uint32_t m = 0;
@@ -261,7 +286,17 @@ TRACE_DEVICE(TRACE_DEVICE_OPT)
 			pr_fatal_error("unknown device: %.*s\n",
 				(int)dev.length, dev.s);
 
-	return (struct trace_mode) { .m = m };
+	return m;
+}
+
+static enum trace_format trace_format_option(const char *s)
+{
+	if (strcmp(s, "text") == 0)
+		return TRACE_FORMAT_TEXT;
+	if (strcmp(s, "binary") == 0)
+		return TRACE_FORMAT_BINARY;
+
+	pr_fatal_error("unknown trace format: %s\n", s);
 }
 
 psgplay_digital_to_stereo_cb psg_mix_option(void)
@@ -290,6 +325,22 @@ void *psg_mix_arg(void)
 	return NULL;
 }
 
+char *psg_mix_key(void)
+{
+	const struct psgplay_psg_stereo_balance *b = &option.psg_balance;
+	const struct psgplay_psg_stereo_volume *v = &option.psg_volume;
+	struct strbuf sb = { };
+
+	if (!(strcmp(option.psg_mix, "balance") == 0 ?
+			sbprintf(&sb, "balance %.9g:%.9g:%.9g", b->a, b->b, b->c) :
+	      strcmp(option.psg_mix, "volume") == 0 ?
+			sbprintf(&sb, "volume %.9g:%.9g:%.9g", v->a, v->b, v->c) :
+			sbprintf(&sb, "%s", option.psg_mix)))
+		pr_fatal_errno("psg_mix_key");
+
+	return sb.s;
+}
+
 static void set_psg_mix(const char *psg_mix)
 {
 	if (option.psg_mix && strcmp(option.psg_mix, psg_mix) != 0)
@@ -313,6 +364,7 @@ struct options *parse_options(int argc, char **argv)
 		{ "start",               required_argument, NULL, 0 },
 		{ "stop",                required_argument, NULL, 0 },
 		{ "length",              required_argument, NULL, 0 },
+		{ "silence",             required_argument, NULL, 0 },
 
 		{ "mode",                required_argument, NULL, 0 },
 
@@ -323,12 +375,19 @@ struct options *parse_options(int argc, char **argv)
 		{ "psg-balance",         required_argument, NULL, 0 },
 		{ "psg-volume",          required_argument, NULL, 0 },
 
+		{ "cache",               required_argument, NULL, 0 },
+		{ "cache-size",          required_argument, NULL, 0 },
+
+		{ "export-ym",           required_argument, NULL, 0 },
+		{ "export-format",       required_argument, NULL, 0 },
+
 		{ "disassemble",         no_argument,       NULL, 0 },
 		{ "disassemble-header",  no_argument,       NULL, 0 },
 		{ "disassemble-address", no_argument,       NULL, 0 },
 		{ "remake-header",       no_argument,       NULL, 0 },
 
 		{ "trace-output",        required_argument, NULL, 0 },
+		{ "trace-format",        required_argument, NULL, 0 },
 		{ "trace",               required_argument, NULL, 0 },
 
 		{ NULL, 0, NULL, 0 }
@@ -341,6 +400,7 @@ struct options *parse_options(int argc, char **argv)
 	option.track = -1;
 	option.frequency = 44100;
 	option.psg_mix = NULL;
+	option.cache_size = CACHE_SIZE_DEFAULT;
 
 	for (;;) {
 		int index = 0;
@@ -373,6 +433,8 @@ struct options *parse_options(int argc, char **argv)
 				option.stop = optarg;
 			else if (OPT("length"))
 				option.length = optarg;
+			else if (OPT("silence"))
+				option.silence = optarg;
 
 			else if (OPT("mode"))
 				goto opt_m;
@@ -392,6 +454,16 @@ struct options *parse_options(int argc, char **argv)
 				set_psg_mix("volume");
 			}
 
+			else if (OPT("cache"))
+				option.cache = optarg;
+			else if (OPT("cache-size"))
+				option.cache_size = cache_size_option(optarg);
+
+			else if (OPT("export-ym"))
+				option.export_ym = optarg;
+			else if (OPT("export-format"))
+				option.export_format = optarg;
+
 			else if (OPT("disassemble"))
 				option.disassemble = DISASSEMBLE_TYPE_ALL;
 			else if (OPT("disassemble-header"))
@@ -403,8 +475,10 @@ struct options *parse_options(int argc, char **argv)
 
 			else if (OPT("trace-output"))
 				option.trace.output = optarg;
+			else if (OPT("trace-format"))
+				option.trace.format = trace_format_option(optarg);
 			else if (OPT("trace"))
-				option.trace = trace_option(optarg);
+				option.trace.m = trace_option(optarg);
 			break;
 
 		case 'h':
@@ -444,6 +518,22 @@ out:
 	if (!option.psg_mix)
 		set_psg_mix("empiric");
 
+	if (!option.export_format)
+		option.export_format = "ym6";
+	else if (strcmp(option.export_format, "ym6") != 0 &&
+		 strcmp(option.export_format, "ym5") != 0 &&
+		 strcmp(option.export_format, "log") != 0)
+		pr_fatal_error("unknown export format: %s\n",
+			option.export_format);
+
+	if (option.trace.format == TRACE_FORMAT_BINARY && option.trace.m) {
+		option.trace.m &= ~TRACE_DEVICE_TEXT;
+
+		if (!option.trace.m)
+			pr_fatal_error("binary trace format excludes "
+				"wch, cpu and reg\n");
+	}
+
 	if (optind == argc)
 		pr_fatal_error("missing input SNDH file\n");
 	if (optind + 1 < argc)
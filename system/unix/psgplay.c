@@ -67,6 +67,13 @@ static void NORETURN trace_exit(struct options *options, struct file file)
 }
 #endif
 
+static void NORETURN export_exit(struct options *options, struct file file)
+{
+	command_export(options, file);
+
+	exit(EXIT_SUCCESS);
+}
+
 static int default_subtune(struct file file)
 {
 	int track;
@@ -111,6 +118,23 @@ static const struct audio_writer *select_output(const struct options *options)
 	return &wave_writer;
 }
 
+static void trace_header(struct trace_mode *trace)
+{
+	if (trace->format == TRACE_FORMAT_TEXT) {
+		fprintf(trace->file, "sys type psgplay\n");
+		return;
+	}
+
+	/* Binary traces are large, so they are written in large blocks. */
+	static char buffer[1024 * 1024];
+	const uint32_t record_size = sizeof(struct trace_record);
+
+	setvbuf(trace->file, buffer, _IOFBF, sizeof(buffer));
+
+	fwrite(TRACE_BINARY_MAGIC, 4, 1, trace->file);
+	fwrite(&record_size, sizeof(record_size), 1, trace->file);
+}
+
 static replay_f select_replay(const struct options *options)
 {
 	return text_mode_option() ? text_replay : command_replay;
@@ -131,7 +155,7 @@ int main(int argc, char *argv[])
 		options->trace.file = stdout;
 
 	if (options->trace.m != TRACE_DEVICE_NONE)
-		fprintf(options->trace.file, "sys type psgplay\n");
+		trace_header(&options->trace);
 
 	struct file file = sndh_read_file(options->input);
 	if (!file_valid(file))
@@ -151,6 +175,9 @@ int main(int argc, char *argv[])
 
 	select_subtune(&options->track, file);
 
+	if (options->export_ym)
+		export_exit(options, file);
+
 	select_replay(options)(options, file, select_output(options));
 
 	file_free(file);
@@ -41,6 +41,13 @@
  */
 #define BUFFER_UPDATE_TIME 20	/* 20 ms */
 
+/*
+ * Snapshots are taken periodically while playing, such that rewinding
+ * restores the nearest preceding snapshot rather than emulating from the
+ * start of the tune.
+ */
+#define CHECKPOINT_TIME 10	/* 10 s */
+
 struct sample_buffer {
 	uint64_t timestamp;	/* ms */
 
@@ -53,6 +60,14 @@ struct sample_buffer {
 
 	struct psgplay *pp;
 
+	struct {
+		size_t count;
+		struct sample_checkpoint {
+			uint64_t frame;
+			struct psgplay_snapshot *snapshot;
+		} c[64];
+	} checkpoint;
+
 	const struct audio_writer *output;
 	void *output_arg;
 };
@@ -157,8 +172,53 @@ static void sample_buffer_flush(struct sample_buffer *sb)
 		sb->output->flush(sb->output_arg);
 }
 
+static void sample_buffer_checkpoint(struct sample_buffer *sb, int frequency)
+{
+	const size_t n = sb->checkpoint.count;
+
+	if (n == ARRAY_SIZE(sb->checkpoint.c) ||
+	    sb->frame < n * CHECKPOINT_TIME * frequency)
+		return;
+
+	struct psgplay_snapshot *snapshot = psgplay_snapshot(sb->pp);
+
+	if (!snapshot)
+		return;
+
+	sb->checkpoint.c[sb->checkpoint.count++] = (struct sample_checkpoint) {
+		.frame = sb->frame,
+		.snapshot = snapshot,
+	};
+}
+
+static bool sample_buffer_restore(struct sample_buffer *sb)
+{
+	for (size_t i = sb->checkpoint.count; i > 0; i--) {
+		const struct sample_checkpoint *c = &sb->checkpoint.c[i - 1];
+
+		if (c->frame <= sb->seek &&
+		    psgplay_restore(sb->pp, c->snapshot) == 0) {
+			sb->frame = c->frame;
+			sb->size = sb->index = 0;
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void sample_buffer_checkpoint_free(struct sample_buffer *sb)
+{
+	for (size_t i = 0; i < sb->checkpoint.count; i++)
+		psgplay_snapshot_free(sb->checkpoint.c[i].snapshot);
+
+	sb->checkpoint.count = 0;
+}
+
 static bool sample_buffer_stop(struct sample_buffer *sb)
 {
+	sample_buffer_checkpoint_free(sb);
 	psgplay_free(sb->pp);
 
 	sb->pp = NULL;
@@ -235,11 +295,13 @@ static uint64_t sample_buffer_update(struct sample_buffer *sb,
 		return 0;
 
 	if (sb->index == sb->size) {
+		sample_buffer_checkpoint(sb, options->frequency);
+
 		if (sb->frame < sb->seek) {
 			/* Seek at most 100 ms at the time. */
 			const size_t s = min_t(uint32_t,
 				options->frequency / 10, sb->seek - sb->frame);
-			const ssize_t r = psgplay_read_stereo(sb->pp, NULL, s);
+			const ssize_t r = psgplay_skip(sb->pp, s);
 
 			if (r <= 0)
 				sb->seek = 0;
@@ -291,6 +353,7 @@ static uint64_t sample_buffer_update(struct sample_buffer *sb,
 
 static void sample_buffer_exit(struct sample_buffer *sb)
 {
+	sample_buffer_checkpoint_free(sb);
 	psgplay_free(sb->pp);
 
 	sb->output->close(sb->output_arg);
@@ -418,6 +481,10 @@ static void model_rewind(struct sample_buffer *sb,
 
 	model->frame = 0;
 
+	if (sample_buffer_restore(sb))
+		return;
+
+	sample_buffer_checkpoint_free(sb);
 	psgplay_free(sb->pp);
 	sb->pp = NULL;
 	sb->frame = sb->size = sb->index = 0;
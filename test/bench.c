@@ -0,0 +1,436 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (C) 2026 Fredrik Noring
+ *
+ * Measure emulation speed per stage, in emulated seconds per wall second.
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "internal/assert.h"
+#include "internal/compare.h"
+#include "internal/macro.h"
+#include "internal/print.h"
+#include "internal/psgplay.h"
+
+#include "atari/cpu.h"
+#include "atari/device.h"
+#include "atari/machine.h"
+
+#include "psgplay/psgplay.h"
+#include "psgplay/sndh.h"
+#include "psgplay/stereo.h"
+
+#include "audio/wave-writer.h"
+
+#include "system/unix/file.h"
+#include "system/unix/memory.h"
+#include "system/unix/sndh.h"
+
+const char *progname = "bench";
+
+/*
+ * Stages are measured by wrapping the function pointers of the machine,
+ * its devices and PSG play. Stages nest, for example digital buffering is
+ * invoked by device output while the CPU runs, and the CPU runs while the
+ * machine runs, so each stage is given its time excluding nested stages.
+ * Device event time is thereby the machine run time remaining after CPU
+ * emulation and digital buffering.
+ */
+#define BENCH_STAGE(s)							\
+	s(CPU,        cpu)						\
+	s(EVENT,      event)						\
+	s(DIGITAL,    digital)						\
+	s(STEREO,     stereo)						\
+	s(DOWNSAMPLE, downsample)					\
+	s(WRITER,     writer)						\
+	s(OTHER,      other)						\
+	s(TOTAL,      total)
+
+enum bench_stage {
+#define BENCH_STAGE_ENUM(symbol_, label_) BENCH_STAGE_##symbol_,
+BENCH_STAGE(BENCH_STAGE_ENUM)
+	BENCH_STAGE_COUNT
+};
+
+struct bench_time {
+	double emulated;
+	uint64_t ns[BENCH_STAGE_COUNT];
+};
+
+static struct bench {
+	uint64_t nested_ns;
+
+	bool (*machine_run)(struct machine *machine);
+	struct device cpu_device;
+
+	psg_sample_f psg_sample;
+	sound_sample_f sound_sample;
+	mixer_sample_f mixer_sample;
+
+	struct {
+		psgplay_stereo_downsample_cb cb;
+		void *arg;
+	} downsample;
+
+	struct bench_time track;
+} bench;
+
+static uint64_t clock_ns(void)
+{
+	struct timespec tp;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &tp) == -1)
+		pr_fatal_errno("clock_gettime");
+
+	return tp.tv_sec * 1000000000ull + tp.tv_nsec;
+}
+
+/**
+ * struct bench_span - time span of a stage
+ * @start: clock in nanoseconds at the start of the stage
+ * @nested_ns: nested time of the enclosing stage, at the start
+ */
+struct bench_span {
+	uint64_t start;
+	uint64_t nested_ns;
+};
+
+static struct bench_span bench_begin(void)
+{
+	const struct bench_span span = {
+		.start = clock_ns(),
+		.nested_ns = bench.nested_ns,
+	};
+
+	bench.nested_ns = 0;
+
+	return span;
+}
+
+static void bench_end(enum bench_stage stage, struct bench_span span)
+{
+	const uint64_t ns = clock_ns() - span.start;
+
+	bench.track.ns[stage] += ns - min(ns, bench.nested_ns);
+	bench.nested_ns = span.nested_ns + ns;
+}
+
+#define BENCH_TIME(stage_, expr_)					\
+({									\
+	const struct bench_span span__ = bench_begin();			\
+	typeof(expr_) r__ = (expr_);					\
+	bench_end(BENCH_STAGE_##stage_, span__);			\
+	r__;								\
+})
+
+static bool bench_machine_run(struct machine *machine)
+{
+	return BENCH_TIME(EVENT, bench.machine_run(machine));
+}
+
+static struct device_slice bench_cpu_run(struct machine *machine,
+	const struct device *device, struct device_cycle cycle,
+	struct device_slice slice)
+{
+	return BENCH_TIME(CPU, cpu_device.run(machine, device, cycle, slice));
+}
+
+static void bench_psg_sample(const struct cf2149_ac *sample,
+	size_t count, void *arg)
+{
+	const struct bench_span span = bench_begin();
+
+	bench.psg_sample(sample, count, arg);
+
+	bench_end(BENCH_STAGE_DIGITAL, span);
+}
+
+static void bench_sound_sample(const struct sound_sample *sample,
+	size_t count, void *arg)
+{
+	const struct bench_span span = bench_begin();
+
+	bench.sound_sample(sample, count, arg);
+
+	bench_end(BENCH_STAGE_DIGITAL, span);
+}
+
+static void bench_mixer_sample(const struct mixer_sample *sample,
+	size_t count, void *arg)
+{
+	const struct bench_span span = bench_begin();
+
+	bench.mixer_sample(sample, count, arg);
+
+	bench_end(BENCH_STAGE_DIGITAL, span);
+}
+
+static void bench_digital_to_stereo(struct psgplay *pp,
+	struct psgplay_stereo *stereo, const struct psgplay_digital *digital,
+	size_t count, void *arg)
+{
+	const struct bench_span span = bench_begin();
+
+	psgplay_digital_to_stereo_empiric(pp, stereo, digital, count, arg);
+
+	bench_end(BENCH_STAGE_STEREO, span);
+}
+
+static size_t bench_downsample(struct psgplay_stereo *resample,
+	const struct psgplay_stereo *stereo, size_t count, void *arg)
+{
+	return BENCH_TIME(DOWNSAMPLE, bench.downsample.cb(resample,
+		stereo, count, bench.downsample.arg));
+}
+
+/*
+ * The CPU device is replaced with a copy having a timed run function,
+ * and the digital sample outputs are replaced with timed ones.
+ */
+static void bench_instrument(struct psgplay *pp)
+{
+	struct machine *machine = &pp->machine;
+	struct machine_device *cpu = &machine->device.list.d[DEVICE_SLOT_CPU];
+
+	BUG_ON(cpu->device != &cpu_device);
+
+	bench.cpu_device = cpu_device;
+	bench.cpu_device.run = bench_cpu_run;
+	cpu->device = &bench.cpu_device;
+
+	bench.machine_run = machine->run;
+	machine->run = bench_machine_run;
+
+	bench.psg_sample = machine->psg.output.sample;
+	machine->psg.output.sample = bench_psg_sample;
+	bench.sound_sample = machine->sound.output.sample;
+	machine->sound.output.sample = bench_sound_sample;
+	bench.mixer_sample = machine->mixer.output.sample;
+	machine->mixer.output.sample = bench_mixer_sample;
+
+	psgplay_digital_to_stereo_callback(pp, bench_digital_to_stereo, NULL);
+
+	bench.downsample.cb = pp->stereo_downsample_callback.cb;
+	bench.downsample.arg = pp->stereo_downsample_callback.arg;
+	psgplay_stereo_downsample_callback(pp, bench_downsample, NULL);
+}
+
+static struct bench_time bench_track(struct file file, int track,
+	float length, int frequency)
+{
+	const uint64_t start = clock_ns();
+	struct psgplay *pp = psgplay_init(file.data, file.size,
+		track, frequency);
+	void *output_arg = wave_writer.open("/dev/null", frequency, false,
+		length * frequency + 0.5);
+	size_t count = 0;
+
+	if (!pp)
+		pr_fatal_error("%s: track %d: failed to init PSG play\n",
+			file.path, track);
+
+	bench = (struct bench) { };
+	bench_instrument(pp);
+
+	psgplay_stop_at_time(pp, length);
+
+	for (;;) {
+		struct psgplay_stereo buffer[4096];
+
+		const ssize_t r = psgplay_read_stereo(
+			pp, buffer, ARRAY_SIZE(buffer));
+
+		if (r < 0)
+			pr_fatal_error("%s: track %d: failed to read PSG play\n",
+				file.path, track);
+		else if (!r)
+			break;
+
+		BENCH_TIME(WRITER, wave_writer.write(buffer, r, output_arg));
+		count += r;
+	}
+
+	wave_writer.close(output_arg);
+	psgplay_free(pp);
+
+	struct bench_time t = bench.track;
+
+	t.emulated = (double)count / frequency;
+	t.ns[BENCH_STAGE_TOTAL] = clock_ns() - start;
+	t.ns[BENCH_STAGE_OTHER] = t.ns[BENCH_STAGE_TOTAL] -
+		min(t.ns[BENCH_STAGE_TOTAL], t.ns[BENCH_STAGE_CPU] +
+			t.ns[BENCH_STAGE_EVENT] +
+			t.ns[BENCH_STAGE_DIGITAL] +
+			t.ns[BENCH_STAGE_STEREO] +
+			t.ns[BENCH_STAGE_DOWNSAMPLE] +
+			t.ns[BENCH_STAGE_WRITER]);
+
+	return t;
+}
+
+static void bench_report(const char *kind, const struct bench_time *t,
+	int track, const char *path)
+{
+	static const char *label[] = {
+#define BENCH_STAGE_LABEL(symbol_, label_) #label_,
+BENCH_STAGE(BENCH_STAGE_LABEL)
+	};
+
+	for (int i = 0; i < BENCH_STAGE_COUNT; i++) {
+		const double wall = t->ns[i] / 1e9;
+
+		printf("%s %-10s %10.3f %10.6f %12.3f %d %s\n",
+			kind, label[i], t->emulated, wall,
+			t->ns[i] ? t->emulated / wall : 0.0, track, path);
+	}
+}
+
+static void bench_add(struct bench_time *sum, const struct bench_time *t)
+{
+	sum->emulated += t->emulated;
+
+	for (int i = 0; i < BENCH_STAGE_COUNT; i++)
+		sum->ns[i] += t->ns[i];
+}
+
+static void bench_file(struct bench_time *sum, const char *path,
+	int track_count, float length, int frequency)
+{
+	struct file file = sndh_read_file(path);
+
+	if (!file_valid(file))
+		pr_fatal_errno(path);
+
+	if (!track_count &&
+	    !sndh_tag_subtune_count(&track_count, file.data, file.size))
+		track_count = 1;
+
+	for (int track = 1; track <= track_count; track++) {
+		const struct bench_time t =
+			bench_track(file, track, length, frequency);
+
+		bench_report("track", &t, track, path);
+		bench_add(sum, &t);
+	}
+
+	file_free(file);
+}
+
+static void bench_suite(struct bench_time *sum, const char *archive,
+	const char *suite, float length, int frequency)
+{
+	struct file file = file_read(suite);
+
+	if (!file_valid(file))
+		pr_fatal_errno(suite);
+
+	char *s = file.data;
+	for (char *line = strtok(s, "\n"); line; line = strtok(NULL, "\n")) {
+		int track_count, n;
+
+		if (sscanf(line, "%d %n", &track_count, &n) != 1)
+			pr_fatal_error("%s: malformed line: %s\n",
+				suite, line);
+
+		char *path = xmalloc(strlen(archive) + 1 + strlen(&line[n]) + 1);
+		sprintf(path, "%s/%s", archive, &line[n]);
+
+		bench_file(sum, path, track_count, length, frequency);
+
+		free(path);
+	}
+
+	file_free(file);
+}
+
+static void NORETURN help_exit(int code)
+{
+	printf(
+"Usage: %s [options]... <sndh-file>...\n"
+"\n"
+"Measure emulation speed per stage, in emulated seconds per wall second.\n"
+"\n"
+"Options:\n"
+"\n"
+"    -h, --help             display this help and exit\n"
+"\n"
+"    -a, --archive=<dir>    directory of files named in the suite\n"
+"    --suite=<file>         archive suite, listing one SNDH file per line\n"
+"                           prefixed with its number of tracks\n"
+"    --length=<seconds>     emulated length of each track (default 30)\n"
+"    -f, --frequency=<num>  set audio frequency in Hz (default 44100)\n"
+"\n"
+"Every track, and then the sum of all tracks, is reported with one line\n"
+"per stage as\n"
+"\n"
+"    <track|all> <stage> <emulated seconds> <wall seconds>\n"
+"        <emulated seconds per wall second> <track> <file>\n"
+"\n"
+"where the stages are cpu, event, digital, stereo, downsample, writer,\n"
+"other and total.\n",
+		progname);
+
+	exit(code);
+}
+
+int main(int argc, char *argv[])
+{
+	static const struct option options[] = {
+		{ "help",      no_argument,       NULL, 'h' },
+		{ "archive",   required_argument, NULL, 'a' },
+		{ "suite",     required_argument, NULL, 's' },
+		{ "length",    required_argument, NULL, 'l' },
+		{ "frequency", required_argument, NULL, 'f' },
+		{ NULL, 0, NULL, 0 }
+	};
+	const char *archive = ".";
+	const char *suite = NULL;
+	float length = 30.0f;
+	int frequency = 44100;
+	struct bench_time sum = { };
+
+	for (;;) {
+		switch (getopt_long(argc, argv, "ha:f:", options, NULL)) {
+		case -1:
+			goto out;
+		case 'h':
+			help_exit(EXIT_SUCCESS);
+		case 'a':
+			archive = optarg;
+			break;
+		case 's':
+			suite = optarg;
+			break;
+		case 'l':
+			length = atof(optarg);
+			break;
+		case 'f':
+			frequency = atoi(optarg);
+			break;
+		default:
+			exit(EXIT_FAILURE);
+		}
+	}
+out:
+	if (optind == argc && !suite)
+		help_exit(EXIT_FAILURE);
+	if (length <= 0)
+		pr_fatal_error("invalid length: %f\n", length);
+	if (frequency <= 0)
+		pr_fatal_error("invalid frequency: %d\n", frequency);
+
+	for (int i = optind; i < argc; i++)
+		bench_file(&sum, argv[i], 0, length, frequency);
+
+	if (suite)
+		bench_suite(&sum, archive, suite, length, frequency);
+
+	bench_report("all", &sum, 0, "-");
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: GPL-2.0
+
+#include "test/report.h"
+#include "test/verify.h"
+#include "test/sndhloop.h"
+
+test_value_time_names(int, tune_value_time_names);
+
+void report(struct strbuf *sb, const struct audio *audio,
+	const struct options *options)
+{
+	report_input(sb, audio, test_name(options), options);
+}
+
+const char *flags(const struct options *options)
+{
+	return "--stop=auto";
+}
+
+const char *verify(const struct audio *audio, const struct options *options)
+{
+	/*
+	 * The tune loops at tick SNDH_LOOP_END after the first tick, which is
+	 * 66150 samples with a 200 Hz timer and 44100 Hz sampling rate. The
+	 * first tick is one timer period after the timer is installed, which
+	 * is within one period of the start, and ticks are timed by the CPU
+	 * cycle of the play call, so allow for a sample of latency.
+	 */
+	const double tick = audio->format.frequency /
+		(double)SNDH_LOOP_FREQUENCY;
+	const double samples = (test_value(options) + 1) * tick;
+
+	verify_assert (audio->format.sample_count >= samples - 1.0 &&
+		       audio->format.sample_count <= samples + tick + 1.0)
+		return "sample duration";
+
+	return NULL;
+}
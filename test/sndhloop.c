@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: GPL-2.0
+
+#include <asm/snd/psg.h>
+#include <asm/snd/sndh.h>
+
+#include "test/sndhloop.h"
+
+sndh_title("SNDH loop at tick " XSTR(SNDH_LOOP_END));
+sndh_timer(SNDH_TIMER_C, SNDH_LOOP_FREQUENCY);
+
+static int tick;
+
+void sndh_init(int32_t tune)
+{
+	snd_psg_wr_iomix(SND_PSG_IOMIX_OFF);
+	snd_psg_wr_level_a(SND_PSG_LEVEL_MAX);
+}
+
+/*
+ * The pitch changes with each tick, until the tick counter wraps from
+ * SNDH_LOOP_END to SNDH_LOOP_START, which repeats the machine state.
+ */
+void sndh_play(void)
+{
+	tick = tick + 1 < SNDH_LOOP_END ? tick + 1 : SNDH_LOOP_START;
+
+	snd_psg_wr_period_a(100 + tick);
+	snd_psg_wr_iomix(SND_PSG_IOMIX_TONE_A);
+}
+
+void sndh_exit(void)
+{
+	snd_psg_wr_iomix(SND_PSG_IOMIX_OFF);
+}